@@ -6,12 +6,13 @@
 
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 
 #define MIN(x,y)	(((x)<(y))?(x):(y))
 
 // prototype
 void colormap_init(pixel_t *, int);
-void draw_image   (pixmap_t *, pixel_t *, int, double, double, double);
+void draw_image   (pixmap_t *, pixel_t *, int, double, double, double, tile_sched_t *);
 int  mandelbrot   (int, double, double);
 
 //======================================================================
@@ -19,14 +20,18 @@ int main(int argc, char **argv)
 {
     pixmap_t image;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
 
-    pixmap_create(&image, WIDTH, HEIGHT);
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);
+    pixmap_allocate(&image, WIDTH, HEIGHT);
+    tile_sched_first_touch(&sched, image.data, sizeof(pixel_t));
     colormap_init(colormap, ITER_MAX);
 
-    draw_image(&image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, &sched);
 
     pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&image);
+    tile_sched_fin(&sched);
 
     return 0;
 }
@@ -52,7 +57,7 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(pixmap_t *image, pixel_t *colormap, int iter_max,
-				double c_r, double c_i, double radius)
+				double c_r, double c_i, double radius, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
     int width, height;
@@ -62,14 +67,19 @@ void draw_image(pixmap_t *image, pixel_t *colormap, int iter_max,
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1) collapse(2)
-    for (int j = 0; j < height; j++) {
-	for (int i = 0; i < width; i++) {
-	    double p_r = c_r + d * (i - width  / 2),
-		   p_i = c_i + d * (height / 2 - j);
-	    int   iter = mandelbrot(iter_max, p_r, p_i);
-	    pixmap_put_pixel(image, colormap[iter & iter_mask], i, j);
-	}
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int j = tile.y; j < tile.y + tile.height; j++)
+		for (int i = tile.x; i < tile.x + tile.width; i++) {
+		    double p_r = c_r + d * (i - width  / 2),
+			   p_i = c_i + d * (height / 2 - j);
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+		    pixmap_put_pixel(image, colormap[iter & iter_mask], i, j);
+		}
     }
 
     return;
@@ -7,13 +7,14 @@
 #include <math.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 
 #define ROUND(x)	((int) round(x))
 #define MIN(x,y)	(((x)<(y))?(x):(y))
 
 // prototypes
 void colormap_init(pixel_t *, int);
-void draw_image   (pixmap_t *, pixel_t *, int, int, double, double, double);
+void draw_image   (pixmap_t *, pixel_t *, int, int, double, double, double, tile_sched_t *);
 int  mandelbrot   (int, double, double);
 
 //======================================================================
@@ -21,14 +22,18 @@ int main(int argc, char **argv)
 {
     pixmap_t image;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
 
-    pixmap_create(&image, WIDTH, HEIGHT);
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);
+    pixmap_allocate(&image, WIDTH, HEIGHT);
+    tile_sched_first_touch(&sched, image.data, sizeof(pixel_t));
     colormap_init(colormap, ITER_MAX);
 
-    draw_image(&image, colormap, ITER_MAX, AALEV, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&image, colormap, ITER_MAX, AALEV, CENTER_R, CENTER_I, RADIUS, &sched);
 
     pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&image);
+    tile_sched_fin(&sched);
 
     return 0;
 }
@@ -54,7 +59,7 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(pixmap_t *image, pixel_t *colormap, int iter_max,
-		int sampling, double c_r, double c_i, double radius)
+		int sampling, double c_r, double c_i, double radius, tile_sched_t *sched)
 {				// simple anti-aliasing based on super-sampling
     int iter_mask = iter_max - 1;
     int width, height;
@@ -64,25 +69,30 @@ void draw_image(pixmap_t *image, pixel_t *colormap, int iter_max,
 
     d = 2.0 * radius / (sampling * MIN(width, height));
 
-#pragma omp parallel for schedule(static,1) collapse(2)
-    for (int j = 0; j < height; j++) {
-	for (int i = 0; i < width; i++) {
-	    int sum_r = 0, sum_g = 0, sum_b = 0;
-	    pixel_t pixel;
-	    for (int n = j * sampling; n < (j + 1) * sampling; n++)
-		for (int m = i * sampling; m < (i + 1) * sampling; m++) {
-		    double p_r = c_r + d * (m - sampling * width  / 2),
-			   p_i = c_i + d * (sampling * height / 2 - n);
-		    int   iter = mandelbrot(iter_max, p_r, p_i);
-		    sum_r += pixel_get_r(colormap[iter & iter_mask]);
-		    sum_g += pixel_get_g(colormap[iter & iter_mask]);
-		    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int j = tile.y; j < tile.y + tile.height; j++)
+		for (int i = tile.x; i < tile.x + tile.width; i++) {
+		    int sum_r = 0, sum_g = 0, sum_b = 0;
+		    pixel_t pixel;
+		    for (int n = j * sampling; n < (j + 1) * sampling; n++)
+			for (int m = i * sampling; m < (i + 1) * sampling; m++) {
+			    double p_r = c_r + d * (m - sampling * width  / 2),
+				   p_i = c_i + d * (sampling * height / 2 - n);
+			    int   iter = mandelbrot(iter_max, p_r, p_i);
+			    sum_r += pixel_get_r(colormap[iter & iter_mask]);
+			    sum_g += pixel_get_g(colormap[iter & iter_mask]);
+			    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			}
+		    pixel = pixel_set_rgb(ROUND((double) sum_r / (sampling * sampling)),
+					  ROUND((double) sum_g / (sampling * sampling)),
+					  ROUND((double) sum_b / (sampling * sampling)));
+		    pixmap_put_pixel(image, pixel, i, j);
 		}
-	    pixel = pixel_set_rgb(ROUND((double) sum_r / (sampling * sampling)),
-				  ROUND((double) sum_g / (sampling * sampling)),
-				  ROUND((double) sum_b / (sampling * sampling)));
-	    pixmap_put_pixel(image, pixel, i, j);
-	}
     }
 
     return;
@@ -69,22 +69,21 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
     int              width, height;
     cl_program       program = cl_query_program(obj);
     cl_command_queue queue   = cl_query_queue  (obj);
-    cl_context       context = cl_query_context(obj);
     cl_kernel        kernel  = NULL;
     cl_mem           dev_pixmap, dev_colormap;
     size_t           global_size[2];
 
     pixmap_get_size(image, &width, &height);
 
-    // memory allocation on GPU
-    dev_pixmap   = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_colormap = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			iter_max       * sizeof(pixel_t), NULL, NULL);
+    // memory allocation on GPU (host data is used in place on unified memory)
+    dev_pixmap   = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			width * height * sizeof(pixel_t), image->data);
+    dev_colormap = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // CPU->GPU memory copy
-    clEnqueueWriteBuffer(queue, dev_colormap, CL_TRUE, 0,
-			iter_max       * sizeof(pixel_t), colormap, 0, NULL, NULL);
+    cl_write_buffer(obj, dev_colormap, 0,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // load kernel function
     kernel = clCreateKernel(program, "antialiasing_GPU", NULL);
@@ -108,8 +107,8 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
     clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
 
     // GPU->CPU memory copy
-    clEnqueueReadBuffer(queue, dev_pixmap, CL_TRUE, 0,
-			width * height * sizeof(pixel_t), image->data, 0, NULL, NULL);
+    cl_read_buffer(obj, dev_pixmap, 0,
+			width * height * sizeof(pixel_t), image->data);
 
     clFlush (queue);
     clFinish(queue);
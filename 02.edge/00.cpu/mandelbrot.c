@@ -7,6 +7,7 @@
 #include <math.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 #define ROUND(x)	((int) round(x))
@@ -15,8 +16,8 @@
 
 // prototypes
 void colormap_init   (pixel_t  *, int);
-void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, double, double, double);
-void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double);
+void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, double, double, double, tile_sched_t *);
+void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double, tile_sched_t *);
 int  mandelbrot      (int, double, double);
 bool detect_edge     (pixmap_t *, pixel_t  *, int, int);
 bool equivalent_color(pixel_t, pixel_t);
@@ -26,16 +27,21 @@ int main(int argc, char **argv)
 {
     pixmap_t image, sketch;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
 
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);
+    pixmap_allocate(&image , WIDTH, HEIGHT);
+    pixmap_allocate(&sketch, WIDTH, HEIGHT);
+    tile_sched_first_touch(&sched, image .data, sizeof(pixel_t));
+    tile_sched_first_touch(&sched, sketch.data, sizeof(pixel_t));
     colormap_init(colormap, ITER_MAX);
 
-    draw_image(&image, &sketch, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&image, &sketch, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, &sched);
 
     pixmap_write_ppmfile(&image, "output.pbm");
     pixmap_destroy(&sketch);
     pixmap_destroy(&image );
+    tile_sched_fin(&sched);
 
     return 0;
 }
@@ -61,26 +67,31 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {				// draw edge image.
     const pixel_t black = pixel_set_rgb(0x00, 0x00, 0x00),
 		  white = pixel_set_rgb(0xff, 0xff, 0xff);
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius);
+    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius, sched);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0;  xy < WIDTH * HEIGHT; xy++) {
-	const int x = xy % WIDTH,
-		  y = xy / WIDTH;
-	bool edge;
-	pixel_t pixel;
-	edge  = detect_edge(sketch, &pixel, x, y);
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    bool edge;
+		    pixel_t pixel;
+		    edge  = detect_edge(sketch, &pixel, x, y);
 #ifdef USE_MONOCHROME
-	pixel = edge ? white : black;
+		    pixel = edge ? white : black;
 #else
-	pixel = edge ? white : pixel;
+		    pixel = edge ? white : pixel;
 #endif
-	pixmap_put_pixel(image, pixel, x, y);
+		    pixmap_put_pixel(image, pixel, x, y);
+		}
     }
 
     return;
@@ -88,7 +99,7 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
 //----------------------------------------------------------------------
 void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
     int width, height;
@@ -98,14 +109,19 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0; xy < WIDTH * HEIGHT; xy++) {
-	int    x   = xy % WIDTH,
-	       y   = xy / WIDTH;
-	double p_r = c_r + d * (x - width  / 2),
-	       p_i = c_i + d * (height / 2 - y);
-	int   iter = mandelbrot(iter_max, p_r, p_i);
-	pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    double p_r = c_r + d * (x - width  / 2),
+			   p_i = c_i + d * (height / 2 - y);
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+		}
     }
 
     return;
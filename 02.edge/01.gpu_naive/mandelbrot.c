@@ -86,17 +86,17 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
 
     pixmap_get_size(image, &width, &height);
 
-    // memory allocation on GPU
+    // memory allocation on GPU (host data is used in place on unified memory)
     dev_sketch   = clCreateBuffer(context, CL_MEM_READ_WRITE,
 			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_pixmap   = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_colormap = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			iter_max       * sizeof(pixel_t), NULL, NULL);
+    dev_pixmap   = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			width * height * sizeof(pixel_t), image->data);
+    dev_colormap = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // CPU->GPU memory copy
-    clEnqueueWriteBuffer(queue, dev_colormap, CL_TRUE, 0,
-			iter_max       * sizeof(pixel_t), colormap, 0, NULL, NULL);
+    cl_write_buffer(obj, dev_colormap, 0,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // draw rough sketch image
     rough_sketch(obj, dev_sketch, width, height, dev_colormap, iter_max, c_r, c_i, radius);
@@ -118,8 +118,8 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
     clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
 
     // GPU->CPU memory copy
-    clEnqueueReadBuffer(queue, dev_pixmap, CL_TRUE, 0,
-			width * height * sizeof(pixel_t), image->data, 0, NULL, NULL);
+    cl_read_buffer(obj, dev_pixmap, 0,
+			width * height * sizeof(pixel_t), image->data);
 
     clFlush (queue);
     clFinish(queue);
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 #define ROUND(x)	((int) round(x))
@@ -16,8 +17,8 @@
 
 // prototypes
 void colormap_init   (pixel_t *, int);
-void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, int, double, double, double);
-void rough_sketch    (pixmap_t *,             pixel_t *, int,      double, double, double);
+void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, int, double, double, double, tile_sched_t *);
+void rough_sketch    (pixmap_t *,             pixel_t *, int,      double, double, double, tile_sched_t *);
 int  mandelbrot      (int, double, double);
 bool detect_edge     (pixmap_t *, pixel_t  *, int, int);
 bool equivalent_color(pixel_t, pixel_t);
@@ -27,16 +28,21 @@ int main(int argc, char **argv)
 {
     pixmap_t image, sketch;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
 
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);
+    pixmap_allocate(&image , WIDTH, HEIGHT);
+    pixmap_allocate(&sketch, WIDTH, HEIGHT);
+    tile_sched_first_touch(&sched, image .data, sizeof(pixel_t));
+    tile_sched_first_touch(&sched, sketch.data, sizeof(pixel_t));
     colormap_init(colormap, ITER_MAX);
 
-    draw_image(&image, &sketch, colormap, ITER_MAX, AALEV, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&image, &sketch, colormap, ITER_MAX, AALEV, CENTER_R, CENTER_I, RADIUS, &sched);
 
     pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&sketch);
     pixmap_destroy(&image );
+    tile_sched_fin(&sched);
 
     return 0;
 }
@@ -62,7 +68,7 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, int sampling, double c_r, double c_i, double radius)
+		int iter_max, int sampling, double c_r, double c_i, double radius, tile_sched_t *sched)
 {				// simple anti-aliasing based on multi-sampling
     int iter_mask = iter_max - 1;
     int width, height;
@@ -72,29 +78,34 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / (sampling * MIN(width, height));
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius);
-
-#pragma omp parallel for schedule(static,1) collapse(2)
-    for (int j = 0; j < height; j++) {
-	for (int i = 0; i < width; i++) {
-	    pixel_t pixel;
-	    if (detect_edge(sketch, &pixel, i, j)) {	// over-sampling for edge
-		int sum_r = 0, sum_g = 0, sum_b = 0;
-		for (int n = j * sampling; n < (j + 1) * sampling; n++)
-		    for (int m = i * sampling; m < (i + 1) * sampling; m++) {
-			double p_r = c_r + d * (m - sampling * width  / 2),
-			       p_i = c_i + d * (sampling * height / 2 - n);
-			int   iter = mandelbrot(iter_max, p_r, p_i);
-			sum_r += pixel_get_r(colormap[iter & iter_mask]);
-			sum_g += pixel_get_g(colormap[iter & iter_mask]);
-			sum_b += pixel_get_b(colormap[iter & iter_mask]);
+    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius, sched);
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int j = tile.y; j < tile.y + tile.height; j++)
+		for (int i = tile.x; i < tile.x + tile.width; i++) {
+		    pixel_t pixel;
+		    if (detect_edge(sketch, &pixel, i, j)) {	// over-sampling for edge
+			int sum_r = 0, sum_g = 0, sum_b = 0;
+			for (int n = j * sampling; n < (j + 1) * sampling; n++)
+			    for (int m = i * sampling; m < (i + 1) * sampling; m++) {
+				double p_r = c_r + d * (m - sampling * width  / 2),
+				       p_i = c_i + d * (sampling * height / 2 - n);
+				int   iter = mandelbrot(iter_max, p_r, p_i);
+				sum_r += pixel_get_r(colormap[iter & iter_mask]);
+				sum_g += pixel_get_g(colormap[iter & iter_mask]);
+				sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			    }
+			pixel = pixel_set_rgb(ROUND((double) sum_r / (sampling * sampling)),
+					      ROUND((double) sum_g / (sampling * sampling)),
+					      ROUND((double) sum_b / (sampling * sampling)));
 		    }
-		pixel = pixel_set_rgb(ROUND((double) sum_r / (sampling * sampling)),
-				      ROUND((double) sum_g / (sampling * sampling)),
-				      ROUND((double) sum_b / (sampling * sampling)));
-	    }
-	    pixmap_put_pixel(image, pixel, i, j);
-	}
+		    pixmap_put_pixel(image, pixel, i, j);
+		}
     }
 
     return;
@@ -102,7 +113,7 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
 //----------------------------------------------------------------------
 void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
     int width, height;
@@ -112,14 +123,19 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1) collapse(2)
-    for (int j = 0; j < height; j++) {
-	for (int i = 0; i < width; i++) {
-	    double p_r = c_r + d * (i - width  / 2),
-		   p_i = c_i + d * (height / 2 - j);
-	    int   iter = mandelbrot(iter_max, p_r, p_i);
-	    pixmap_put_pixel(sketch, colormap[iter & iter_mask], i, j);
-	}
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int j = tile.y; j < tile.y + tile.height; j++)
+		for (int i = tile.x; i < tile.x + tile.width; i++) {
+		    double p_r = c_r + d * (i - width  / 2),
+			   p_i = c_i + d * (height / 2 - j);
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], i, j);
+		}
     }
 
     return;
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 // for adaptive mesh refinement
@@ -20,8 +21,8 @@
 
 // prototypes
 void colormap_init   (pixel_t  *, int);
-void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, double, double, double);
-void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double);
+void draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int, double, double, double, tile_sched_t *);
+void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double, tile_sched_t *);
 int  mandelbrot      (int, double, double);
 bool detect_edge     (pixmap_t *, pixel_t  *, int, int);
 bool equivalent_color(pixel_t, pixel_t);
@@ -31,16 +32,21 @@ int main(int argc, char **argv)
 {
     pixmap_t image, sketch;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
 
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);
+    pixmap_allocate(&image , WIDTH, HEIGHT);
+    pixmap_allocate(&sketch, WIDTH, HEIGHT);
+    tile_sched_first_touch(&sched, image .data, sizeof(pixel_t));
+    tile_sched_first_touch(&sched, sketch.data, sizeof(pixel_t));
     colormap_init(colormap, ITER_MAX);
 
-    draw_image(&image, &sketch, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&image, &sketch, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, &sched);
 
     pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&sketch);
     pixmap_destroy(&image );
+    tile_sched_fin(&sched);
 
     return EXIT_SUCCESS;
 }
@@ -66,7 +72,7 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {				// adaptive mesh refinement
     int iter_mask = iter_max - 1;
     int width, height;
@@ -76,43 +82,48 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius);
-
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0;  xy < width * height; xy++) {
-	int x = xy % width,
-	    y = xy / width;
-	pixel_t pixel;
-	if (detect_edge(sketch, &pixel, x, y)) {
-	    pixel_t average = pixel;
-	    int sum_r, sum_g, sum_b;
-	    sum_r = pixel_get_r(pixel);
-	    sum_g = pixel_get_g(pixel);
-	    sum_b = pixel_get_b(pixel);
-	    for (int ngrid = MIN_GRID; ngrid <= MAX_GRID; ngrid <<= 0x01) {
-		pixel = average;
-		for (int k = 1; k < ngrid * ngrid; k++) {	// pixel refinement with AMR
-		    int m = k % ngrid,
-			n = k / ngrid;
-		    if (((m | n) & 0x01) ||	// skip redundant points: (m % 2) != 0 || (n % 2) != 0
-			ngrid == MIN_GRID) {
-			double p_r = c_r + d * ((x + (double) m / ngrid) - width  / 2),
-			       p_i = c_i + d * (height / 2 - (y + (double) n / ngrid));
-			int   iter = mandelbrot(iter_max, p_r, p_i);
-			sum_r += pixel_get_r(colormap[iter & iter_mask]);
-			sum_g += pixel_get_g(colormap[iter & iter_mask]);
-			sum_b += pixel_get_b(colormap[iter & iter_mask]);
+    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius, sched);
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    pixel_t pixel;
+		    if (detect_edge(sketch, &pixel, x, y)) {
+			pixel_t average = pixel;
+			int sum_r, sum_g, sum_b;
+			sum_r = pixel_get_r(pixel);
+			sum_g = pixel_get_g(pixel);
+			sum_b = pixel_get_b(pixel);
+			for (int ngrid = MIN_GRID; ngrid <= MAX_GRID; ngrid <<= 0x01) {
+			    pixel = average;
+			    for (int k = 1; k < ngrid * ngrid; k++) {	// pixel refinement with AMR
+				int m = k % ngrid,
+				    n = k / ngrid;
+				if (((m | n) & 0x01) ||	// skip redundant points: (m % 2) != 0 || (n % 2) != 0
+				    ngrid == MIN_GRID) {
+				    double p_r = c_r + d * ((x + (double) m / ngrid) - width  / 2),
+					   p_i = c_i + d * (height / 2 - (y + (double) n / ngrid));
+				    int   iter = mandelbrot(iter_max, p_r, p_i);
+				    sum_r += pixel_get_r(colormap[iter & iter_mask]);
+				    sum_g += pixel_get_g(colormap[iter & iter_mask]);
+				    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+				}
+			    }
+			    average = pixel_set_rgb(ROUND((double) sum_r / (ngrid * ngrid)),
+						    ROUND((double) sum_g / (ngrid * ngrid)),
+						    ROUND((double) sum_b / (ngrid * ngrid)));
+			    if (equivalent_color(average, pixel))
+				break;
+			}
+			pixel = average;
 		    }
+		    pixmap_put_pixel(image, pixel, x, y);
 		}
-		average = pixel_set_rgb(ROUND((double) sum_r / (ngrid * ngrid)),
-					ROUND((double) sum_g / (ngrid * ngrid)),
-					ROUND((double) sum_b / (ngrid * ngrid)));
-		if (equivalent_color(average, pixel))
-		    break;
-	    }
-	    pixel = average;
-	}
-	pixmap_put_pixel(image, pixel, x, y);
     }
 
     return;
@@ -120,7 +131,7 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
 //----------------------------------------------------------------------
 void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
     int width, height;
@@ -130,14 +141,19 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0;  xy < width * height; xy++) {
-	int    x   = xy % width,
-	       y   = xy / width;
-	double p_r = c_r + d * (x - width  / 2),
-	       p_i = c_i + d * (height / 2 - y);
-	int   iter = mandelbrot(iter_max, p_r, p_i);
-	pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    double p_r = c_r + d * (x - width  / 2),
+			   p_i = c_i + d * (height / 2 - y);
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+		}
     }
 
     return;
@@ -58,9 +58,9 @@ __kernel void antialiasing_GPU
 #if 0
     int x = get_global_id(0),
 	y = get_global_id(1);
-#else
-    int x = get_group_id(0) + get_num_groups(0) * get_local_id(0),
-	y = get_group_id(1) + get_num_groups(1) * get_local_id(1);
+#else				// group IDs do not include the global offset.
+    int x = get_global_offset(0) + get_group_id(0) + get_num_groups(0) * get_local_id(0),
+	y = get_global_offset(1) + get_group_id(1) + get_num_groups(1) * get_local_id(1);
 #endif
     uchar4 pixel;
 
@@ -4,6 +4,12 @@
  * $Id: mandelbrot.c,v 1.1.1.6 2021/07/21 00:00:00 seiji Exp seiji $
  */
 
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
 #include <pixmap.h>
 #include <palette.h>
 #include <cl_util.h>
@@ -13,7 +19,10 @@
 
 // prototype
 void colormap_init(pixel_t *, int);
-void draw_image   (cl_obj_t *, pixmap_t *, pixel_t *, int, double, double, double);
+void draw_image   (cl_obj_t *, pixmap_t *, pixel_t *, int, double, double, double, int, int);
+void block_range  (int, int, int, int *, int *);
+void pixmap_gather(pixmap_t *, int, int);
+cl_uint device_select(int);
 
 //======================================================================
 int main(int argc, char **argv)
@@ -29,24 +38,46 @@ int main(int argc, char **argv)
 		"-DSIZEOF_PIXEL_T=4";
 #endif
 
+    int      nprocs = 1, myrank = 0,
+	     y_head, y_tail;	// row block rendered by this PE
     pixmap_t image;
     pixel_t  colormap[ITER_MAX];
 
-    // initialize OpenCL
-    cl_init(&obj, NULL, OPENCL_DEVICE, 0, KERNEL, options);
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+    if (HEIGHT < nprocs) {	// every PE renders a non-empty row block.
+	if (myrank == 0)
+	    fprintf(stderr, "%s: too many PEs for the image height.\n", argv[0]);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+#endif
+
+    block_range(HEIGHT, nprocs, myrank, &y_head, &y_tail);
+
+    // initialize OpenCL, a distinct device for each PE on a node
+    cl_init(&obj, NULL, OPENCL_DEVICE, device_select(myrank), KERNEL, options);
 
     pixmap_create(&image, WIDTH, HEIGHT);
     colormap_init(colormap, ITER_MAX);
 
     // draw image
-    draw_image(&obj, &image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS);
+    draw_image(&obj, &image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, y_head, y_tail);
+    pixmap_gather(&image, nprocs, myrank);
 
-    pixmap_write_ppmfile(&image, "output.ppm");
+    if (myrank == 0)
+	pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&image);
 
     // finalize OpenCL
     cl_fin(&obj);
 
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+
     return 0;
 }
 
@@ -71,33 +102,37 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
 //----------------------------------------------------------------------
 void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
-{
-    int              width, height;
+		int iter_max, double c_r, double c_i, double radius, int y_head, int y_tail)
+{				// rows [y_head:y_tail) of image are rendered.
+    int              width, height, h_head, h_tail;
     cl_program       program = cl_query_program(obj);
     cl_command_queue queue   = cl_query_queue  (obj);
     cl_context       context = cl_query_context(obj);
     cl_kernel        kernel  = NULL;
     cl_mem           dev_sketch, dev_pixmap, dev_colormap;
-    size_t           global_size[2];
-    void rough_sketch(cl_obj_t *, cl_mem, int, int, cl_mem, int, double, double, double);
+    size_t           global_size[2], global_offset[2];
+    void rough_sketch(cl_obj_t *, cl_mem, int, int, int, int, cl_mem, int, double, double, double);
 
     pixmap_get_size(image, &width, &height);
 
-    // memory allocation on GPU
+    // memory allocation on GPU (host data is used in place on unified memory)
     dev_sketch   = clCreateBuffer(context, CL_MEM_READ_WRITE,
 			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_pixmap   = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_colormap = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			iter_max       * sizeof(pixel_t), NULL, NULL);
+    dev_pixmap   = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			width * height * sizeof(pixel_t), image->data);
+    dev_colormap = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // CPU->GPU memory copy
-    clEnqueueWriteBuffer(queue, dev_colormap, CL_TRUE, 0,
-			iter_max       * sizeof(pixel_t), colormap, 0, NULL, NULL);
+    cl_write_buffer(obj, dev_colormap, 0,
+			iter_max       * sizeof(pixel_t), colormap);
+
+    // rows of sketch to detect edges in the row block: one more row above and below
+    h_head = (y_head > 0     ) ? y_head - 1 : y_head;
+    h_tail = (y_tail < height) ? y_tail + 1 : y_tail;
 
     // draw rough sketch image
-    rough_sketch(obj, dev_sketch, width, height, dev_colormap, iter_max, c_r, c_i, radius);
+    rough_sketch(obj, dev_sketch, width, height, h_head, h_tail, dev_colormap, iter_max, c_r, c_i, radius);
 
     // load kernel function
     kernel = clCreateKernel(program, "antialiasing_GPU", NULL);
@@ -113,16 +148,18 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
     clSetKernelArg(kernel, 7, sizeof(double), &c_i         );
     clSetKernelArg(kernel, 8, sizeof(double), &radius      );
 
-    // set up threads
-    global_size[0] = width ;
-    global_size[1] = height;
+    // set up threads for the row block
+    global_offset[0] = 0;
+    global_offset[1] = y_head;
+    global_size  [0] = width;
+    global_size  [1] = y_tail - y_head;
 
     // calling kernel function
-    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+    clEnqueueNDRangeKernel(queue, kernel, 2, global_offset, global_size, NULL, 0, NULL, NULL);
 
-    // GPU->CPU memory copy
-    clEnqueueReadBuffer(queue, dev_pixmap, CL_TRUE, 0,
-			width * height * sizeof(pixel_t), image->data, 0, NULL, NULL);
+    // GPU->CPU memory copy of the row block
+    cl_read_buffer(obj, dev_pixmap, y_head * width * sizeof(pixel_t),
+			(y_tail - y_head) * width * sizeof(pixel_t), image->data + y_head * width);
 
     clFlush (queue);
     clFinish(queue);
@@ -139,14 +176,14 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
 }
 
 //......................................................................
-void rough_sketch(cl_obj_t *obj, cl_mem dev_sketch, int width, int height,
+void rough_sketch(cl_obj_t *obj, cl_mem dev_sketch, int width, int height, int h_head, int h_tail,
 	cl_mem dev_colormap, int iter_max, double c_r, double c_i, double radius)
-{
+{				// rows [h_head:h_tail) of sketch are drawn.
     cl_program       program = cl_query_program(obj);
     cl_command_queue queue   = cl_query_queue  (obj);
     cl_context       context = cl_query_context(obj);
     cl_kernel        kernel  = NULL;
-    size_t           global_size[2];
+    size_t           global_size[2], global_offset[2];
 
     // load kernel function
     kernel = clCreateKernel(program, "rough_sketch_GPU", NULL);
@@ -162,11 +199,13 @@ void rough_sketch(cl_obj_t *obj, cl_mem dev_sketch, int width, int height,
     clSetKernelArg(kernel, 7, sizeof(double), &radius      );
 
     // set up threads
-    global_size[0] = ROUND_UP(width, VLEN) / VLEN;
-    global_size[1] = height;
+    global_offset[0] = 0;
+    global_offset[1] = h_head;
+    global_size  [0] = ROUND_UP(width, VLEN) / VLEN;
+    global_size  [1] = h_tail - h_head;
 
     // calling kernel function
-    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+    clEnqueueNDRangeKernel(queue, kernel, 2, global_offset, global_size, NULL, 0, NULL, NULL);
 
     clFlush (queue);
     clFinish(queue);
@@ -176,3 +215,79 @@ void rough_sketch(cl_obj_t *obj, cl_mem dev_sketch, int width, int height,
 
     return;
 }
+
+//----------------------------------------------------------------------
+void block_range(int height, int nprocs, int rank, int *y_head, int *y_tail)
+{				// row block [y_head:y_tail) rendered by a PE.
+    *y_head = (long) height *  rank      / nprocs;
+    *y_tail = (long) height * (rank + 1) / nprocs;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void pixmap_gather(pixmap_t *pixmap, int nprocs, int myrank)
+#ifdef USE_MPI
+{				// gather row blocks of pixmap image to PE0.
+    int width, height, *count, *displ;
+
+    pixmap_get_size(pixmap, &width, &height);
+
+    if ((count = (int *) malloc(nprocs * sizeof(int))) == NULL ||
+	(displ = (int *) malloc(nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int p = 0; p < nprocs; p++) {
+	int y_head, y_tail;
+	block_range(height, nprocs, p, &y_head, &y_tail);
+	count[p] = (y_tail - y_head) * width * SIZEOF_PIXEL_T;
+	displ[p] =  y_head           * width * SIZEOF_PIXEL_T;
+    }
+
+    MPI_Gatherv((myrank == 0) ? MPI_IN_PLACE : (char *) pixmap->data + displ[myrank],
+		count[myrank], MPI_BYTE,
+		pixmap->data, count, displ, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    free(displ);
+    free(count);
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+cl_uint device_select(int myrank)
+#ifdef USE_MPI
+{				// collective: PEs on a node take distinct OpenCL devices
+				// of OPENCL_DEVICE type in round-robin.
+    MPI_Comm node;
+    int      rank, size;
+    cl_uint  num_devices = cl_num_devices(NULL, OPENCL_DEVICE);
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myrank, MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &rank);
+    MPI_Comm_size(node, &size);
+    MPI_Comm_free(&node);
+
+    if (num_devices == 0) {
+	fprintf(stderr, "PE%d: no OpenCL device is found.\n", myrank);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (rank == 0 && size > num_devices)
+	fprintf(stderr, "PE%d: %d PEs share %u OpenCL devices on a node.\n",
+						myrank, size, num_devices);
+
+    return rank % num_devices;
+}
+#else				//......................................
+{				// the 1st device
+    return 0;
+}
+#endif
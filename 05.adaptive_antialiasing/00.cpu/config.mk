@@ -2,10 +2,23 @@
 # config.mk
 # $Id: config.mk,v 1.1.1.1 2015/02/26 00:00:00 seiji Exp seiji $
 #=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+# EDGE  : edge detection method [color|distance]
+#........................................................................
+EDGE	= color
+#------------------------------------------------------------------------
 # EQVCLR: equivalent color detection [relaxed|strict]
 #........................................................................
 EQVCLR	= relaxed
 #------------------------------------------------------------------------
+# FRAMES: # of frames rendered with a render context (>1: zoom animation)
+#........................................................................
+FRAMES	= 1
+#------------------------------------------------------------------------
+# GROUP : # of PEs rendering a frame together (MPI)
+#         frames are dealt to groups of PEs on demand.
+#........................................................................
+GROUP	= 1
+#------------------------------------------------------------------------
 # DATA  : input data set [input/$(DATA).dat]
 #........................................................................
 DATA	= 001
@@ -4,17 +4,28 @@
  * $Id: mandelbrot.c,v 1.1.1.4 2020/07/30 00:00:00 seiji Exp seiji $
  */
 
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include <wtime.h>
 #include <time.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 // for adaptive anti-aliasing
 #define MIN_SAMPLES	(0x01<<4)
 #define MAX_SAMPLES	(0x01<<16)
 
+// for distance estimator based edge detection
+#define DE_THRESHOLD	1.0	// refinement threshold [pixel pitch]
+#define DE_BAILOUT	1.E6	// bailout value of |z|^2 for distance estimation
+
 #define ROUND(x)	((int) round(x))
 #define MIN(x,y)	(((x)<(y))?(x):(y))
 #define MAX(x,y)	(((x)>(y))?(x):(y))
@@ -23,40 +34,385 @@
 #define SRAND(s)	srand(s)
 #define DRAND()		((double) rand()/(RAND_MAX+1.0))
 
+// for animation: radius is shrunk by ZOOM_RATIO frame by frame.
+#ifndef FRAMES
+#define FRAMES		1
+#endif
+#define ZOOM_RATIO	1.01
+
+// # of PEs rendering a frame together (MPI)
+#ifndef GROUP_SIZE
+#define GROUP_SIZE	1
+#endif
+
+#define VIEW_LINE_MAX	256
+
+typedef struct {		// view of a frame
+    double c_r, c_i, radius;
+    int    iter_max, palette;
+} view_t;
+
+typedef struct {		// PEs rendering a frame together
+#ifdef USE_MPI
+    MPI_Comm comm;
+    MPI_Win  win;		// frame counter on PE0, taken by group leaders
+    int     *count;
+#endif
+    int      rank, size;	// rank in group, # of PEs in group
+    int      next;		// next frame (without MPI)
+} group_t;
+
+static group_t group;		// group of this PE, used by rows_gather().
+
+typedef struct {		// render context
+    int width, height, iter_max, palette;
+    pixmap_t image, sketch;
+    pixel_t *colormap;
+    double  *dx, *dy;		// jitter tables
+    float   *dist;		// distance estimation map [pixel pitch]
+    tile_sched_t sched;
+} render_t;
+
 // prototypes
-void colormap_init   (pixel_t  *, int);
+int  views_load      (view_t  **, const char *);
+int  views_zoom      (view_t  **);
+void group_init      (group_t  *, int);
+void group_fin       (group_t  *);
+int  group_next      (group_t  *);
+void render_create   (render_t *, int, int, int, int);
+void render_frame    (render_t *, view_t *);
+void render_destroy  (render_t *);
+void block_range     (int, int, int, int *, int *);
+void rows_gather     (void *, size_t, tile_sched_t *, bool);
+void colormap_init   (pixel_t  *, int, int);
 void jitter_init     (double *, double *);
-void draw_image      (pixmap_t *, pixmap_t *, pixel_t *,
-			int, double, double, double, double *, double *);
-void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double);
+void draw_image      (pixmap_t *, pixmap_t *, float *, pixel_t *,
+			int, double, double, double, double *, double *, tile_sched_t *);
+void rough_sketch    (pixmap_t *,             float *, pixel_t *, int, double, double, double, tile_sched_t *);
 int  mandelbrot      (int, double, double);
+int  mandelbrot_de   (int, double, double, double *);
 bool detect_edge     (pixmap_t *, pixel_t  *, int, int);
+bool near_boundary   (float    *, int, int, int, int);
 bool equivalent_color(pixel_t, pixel_t);
 
 //======================================================================
 int main(int argc, char **argv)
-{
-    pixmap_t image, sketch;
-    pixel_t  colormap[ITER_MAX];
-    double   dx[MAX_SAMPLES],
-	     dy[MAX_SAMPLES];
+{				// a list of views given by the argument is rendered in batch,
+				// otherwise a zoom animation into the view of the data set.
+    int      nprocs = 1, myrank = 0, num_views;
+    view_t  *views;
+    render_t render;
+    double   ts, te, tm_setup;
+
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+#endif
+
+    ts        = wtime(true);
+
+    num_views = (argc > 1) ? views_load(&views, argv[1]) : views_zoom(&views);
+
+    group_init(&group, myrank);
+    render_create(&render, WIDTH, HEIGHT, ITER_MAX, COLORMAP_TYPE);
 
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
-    colormap_init(colormap, ITER_MAX);
-    jitter_init(dx, dy);
+    te        = wtime(true);
+    tm_setup  = te - ts;
+    ts        = te;
 
-    draw_image(&image, &sketch, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy);
+    // whole frames are dealt to groups of PEs on demand.
+    for (int k; (k = group_next(&group)) < num_views; ) {
+	render_frame(&render, &views[k]);
+	if (group.rank == 0) {	// frames are written independently by group leaders.
+	    char fname[FILENAME_MAX];
+	    if (argc > 1) {
+		snprintf(fname, sizeof(fname), "frame%05d.ppm", k);
+		pixmap_write_ppmfile(&render.image, fname);
+	    } else if (k == num_views - 1)	// only the last frame of animation
+		pixmap_write_ppmfile(&render.image, "output.ppm");
+	}
+    }
+
+    te        = wtime(true);
+
+    if (myrank == 0 && num_views > 1)
+	printf("Setup=%.6f[sec.], Frame=%.6f[sec.] x %d, Throughput=%.1f[frames/min.] #PE=%d\n",
+		tm_setup, (te - ts) / num_views, num_views, 60.0 * num_views / (te - ts), nprocs);
+
+    render_destroy(&render);
+    group_fin(&group);
+    free(views);
 
-    pixmap_write_ppmfile(&image, "output.ppm");
-    pixmap_destroy(&sketch);
-    pixmap_destroy(&image );
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
 
     return EXIT_SUCCESS;
 }
 
 //----------------------------------------------------------------------
-void colormap_init(pixel_t *colormap, int iter_max)
+int views_load(view_t **views, const char *fname)
+{				// load a list of views, a line "c_r c_i radius [iter_max [palette]]"
+				// for each frame.  ITER_MAX and COLORMAP_TYPE are the defaults,
+				// lines not beginning with a number (e.g. '#') are ignored.
+    FILE *fp;
+    char  line[VIEW_LINE_MAX];
+    int   num_views = 0, size = 0;
+
+    if ((fp = fopen(fname, "r")) == NULL) {
+	perror(fname);
+	exit(EXIT_FAILURE);
+    }
+
+    *views = NULL;
+
+    for (int n = 1; fgets(line, sizeof(line), fp) != NULL; n++) {
+	view_t view = { 0.0, 0.0, 0.0, ITER_MAX, COLORMAP_TYPE };
+	int    c    = sscanf(line, "%lf %lf %lf %d %d", &view.c_r, &view.c_i, &view.radius,
+						   &view.iter_max, &view.palette);
+	if (c <= 0)
+	    continue;
+	if (c < 3 || view.radius <= 0.0 ||	// iter_max is used as a mask of colormap.
+	    view.iter_max < 2 || (view.iter_max & (view.iter_max - 1)) != 0) {
+	    fprintf(stderr, "%s:%d: invalid view (iter_max must be a power of two).\n", fname, n);
+	    exit(EXIT_FAILURE);
+	}
+	if (num_views == size &&
+	    (*views = (view_t *) realloc(*views, (size = 2 * size + 16) * sizeof(view_t))) == NULL) {
+	    perror(__func__);
+	    exit(EXIT_FAILURE);
+	}
+	(*views)[num_views++] = view;
+    }
+
+    fclose(fp);
+
+    if (num_views == 0) {
+	fprintf(stderr, "%s: no view is found.\n", fname);
+	exit(EXIT_FAILURE);
+    }
+
+    return num_views;
+}
+
+//----------------------------------------------------------------------
+int views_zoom(view_t **views)
+{				// zoom into the view of the data set,
+				// radius is shrunk by ZOOM_RATIO frame by frame.
+    if ((*views = (view_t *) malloc(FRAMES * sizeof(view_t))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+    for (int k = 0; k < FRAMES; k++) {
+	(*views)[k].c_r      = CENTER_R;
+	(*views)[k].c_i      = CENTER_I;
+	(*views)[k].radius   = RADIUS * pow(ZOOM_RATIO, FRAMES - 1 - k);
+	(*views)[k].iter_max = ITER_MAX;
+	(*views)[k].palette  = COLORMAP_TYPE;
+    }
+
+    return FRAMES;
+}
+
+//----------------------------------------------------------------------
+void group_init(group_t *group, int myrank)
+#ifdef USE_MPI
+{				// collective: split PEs into groups of GROUP_SIZE PEs,
+				// and create the frame counter on PE0.
+    MPI_Comm_split(MPI_COMM_WORLD, myrank / GROUP_SIZE, myrank, &group->comm);
+    MPI_Comm_rank(group->comm, &group->rank);
+    MPI_Comm_size(group->comm, &group->size);
+
+    MPI_Win_allocate((myrank == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL,
+		     MPI_COMM_WORLD, &group->count, &group->win);
+
+    if (myrank == 0)
+	*group->count = 0;
+    group->next = 0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, group->win);
+
+    return;
+}
+#else				//......................................
+{
+    group->rank = 0;
+    group->size = 1;
+    group->next = 0;
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void group_fin(group_t *group)
+#ifdef USE_MPI
+{				// collective
+    MPI_Win_unlock_all(group->win);
+    MPI_Win_free(&group->win);
+    MPI_Comm_free(&group->comm);
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+int group_next(group_t *group)
+#ifdef USE_MPI
+{				// collective in group: the leader takes the next frame
+				// by an atomic fetch-and-add on PE0.
+    const int one = 1;
+    int k;
+
+    if (group->rank == 0) {
+	MPI_Fetch_and_op(&one, &k, MPI_INT, 0, 0, MPI_SUM, group->win);
+	MPI_Win_flush(0, group->win);
+    }
+
+    MPI_Bcast(&k, 1, MPI_INT, 0, group->comm);
+
+    return k;
+}
+#else				//......................................
+{
+    return group->next++;
+}
+#endif
+
+//----------------------------------------------------------------------
+void render_create(render_t *render, int width, int height, int iter_max, int palette)
+{				// create a render context, which keeps tables,
+				// pixmaps and the scheduler alive across frames.
+				// PEs of a group render their own row blocks of a frame.
+    int y_head, y_tail;
+
+    render->width    = width ;
+    render->height   = height;
+    render->iter_max = iter_max;
+    render->palette  = palette ;
+    render->dist     = NULL;
+
+    block_range(height, group.size, group.rank, &y_head, &y_tail);
+
+    tile_sched_init_rows(&render->sched, width, height, y_head, y_tail);
+    pixmap_allocate(&render->image , width, height);
+    pixmap_allocate(&render->sketch, width, height);
+    tile_sched_first_touch(&render->sched, render->image .data, sizeof(pixel_t));
+    tile_sched_first_touch(&render->sched, render->sketch.data, sizeof(pixel_t));
+#ifdef USE_DISTANCE_ESTIMATOR
+    if ((render->dist = (float *) malloc((size_t) width * height * sizeof(float))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+    tile_sched_first_touch(&render->sched, render->dist, sizeof(float));
+#endif
+
+    if ((render->colormap = (pixel_t *) malloc(iter_max    * sizeof(pixel_t))) == NULL ||
+	(render->dx       = (double  *) malloc(MAX_SAMPLES * sizeof(double ))) == NULL ||
+	(render->dy       = (double  *) malloc(MAX_SAMPLES * sizeof(double ))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+    colormap_init(render->colormap, iter_max, palette);
+    jitter_init  (render->dx, render->dy);
+
+#ifdef USE_MPI			// all PEs use the jitter of PE0 (seeds may differ).
+    MPI_Bcast(render->dx, MAX_SAMPLES, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(render->dy, MAX_SAMPLES, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void render_frame(render_t *render, view_t *view)
+{				// render a frame, all pixels of the image are overwritten.
+				// the image is complete on the group leader only.
+    if (view->iter_max != render->iter_max ||
+	view->palette  != render->palette) {	// colormap of the view
+	if ((render->colormap = (pixel_t *) realloc(render->colormap,
+				view->iter_max * sizeof(pixel_t))) == NULL) {
+	    perror(__func__);
+	    exit(EXIT_FAILURE);
+	}
+	render->iter_max = view->iter_max;
+	render->palette  = view->palette ;
+	colormap_init(render->colormap, render->iter_max, render->palette);
+    }
+
+    draw_image(&render->image, &render->sketch, render->dist, render->colormap,
+		render->iter_max, view->c_r, view->c_i, view->radius, render->dx, render->dy, &render->sched);
+
+    rows_gather(render->image.data, (size_t) render->width * sizeof(pixel_t), &render->sched, false);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void render_destroy(render_t *render)
+{				// destroy a render context.
+    free(render->dy);
+    free(render->dx);
+    free(render->colormap);
+    free(render->dist);
+    pixmap_destroy(&render->sketch);
+    pixmap_destroy(&render->image );
+    tile_sched_fin(&render->sched);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void block_range(int height, int nprocs, int rank, int *y_head, int *y_tail)
+{				// row block [y_head:y_tail) rendered by a PE of a group.
+    *y_head = (long) height *  rank      / nprocs;
+    *y_tail = (long) height * (rank + 1) / nprocs;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void rows_gather(void *data, size_t row_size, tile_sched_t *sched, bool all)
+#ifdef USE_MPI
+{				// gather row blocks of PEs in the group to the leader (or all).
+    int count[group.size], displ[group.size];
+
+    if (group.size == 1)
+	return;
+
+    for (int p = 0; p < group.size; p++) {
+	int y_head, y_tail;
+	block_range(sched->height, group.size, p, &y_head, &y_tail);
+	count[p] = (y_tail - y_head) * row_size;
+	displ[p] =  y_head           * row_size;
+    }
+
+    if (all)
+	MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		       data, count, displ, MPI_BYTE, group.comm);
+    else
+	MPI_Gatherv((group.rank == 0) ? MPI_IN_PLACE : (char *) data + displ[group.rank],
+		    count[group.rank], MPI_BYTE,
+		    data, count, displ, MPI_BYTE, 0, group.comm);
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void colormap_init(pixel_t *colormap, int iter_max, int type)
 {
     int colormap_mask = COLORMAP_CYCLE - 1;
 
@@ -64,11 +420,11 @@ void colormap_init(pixel_t *colormap, int iter_max)
 
     for (int i = 1; i < iter_max; i++)
 #ifdef REVERSE_COLORMAP
-	colormap[i] = palette(COLORMAP_TYPE, 0x00, colormap_mask,
+	colormap[i] = palette(type, 0x00, colormap_mask,
 			      colormap_mask - (i & colormap_mask));
 #else
-	colormap[i] = palette(COLORMAP_TYPE, 0x00, colormap_mask,
-					       i & colormap_mask );
+	colormap[i] = palette(type, 0x00, colormap_mask,
+				      i & colormap_mask );
 #endif
 
     return;
@@ -77,7 +433,11 @@ void colormap_init(pixel_t *colormap, int iter_max)
 //----------------------------------------------------------------------
 void jitter_init(double *dx, double *dy)
 {
+#ifdef SEED
+    SRAND(SEED);
+#else
     SRAND((int) time(NULL));
+#endif
 
     for (int k = 0; k < MAX_SAMPLES; k++) {
 	dx[k] = DRAND();
@@ -88,8 +448,8 @@ void jitter_init(double *dx, double *dy)
 }
 
 //----------------------------------------------------------------------
-void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius, double *dx, double *dy)
+void draw_image(pixmap_t *image, pixmap_t *sketch, float *dist, pixel_t *colormap,
+		int iter_max, double c_r, double c_i, double radius, double *dx, double *dy, tile_sched_t *sched)
 {				// adaptive anti-aliasing
     int iter_mask = iter_max - 1;
     int width, height;
@@ -99,46 +459,62 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius);
-
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0;  xy < width * height; xy++) {
-	int x = xy % width,
-	    y = xy / width;
-	pixel_t pixel;
-	if (detect_edge(sketch, &pixel, x, y)) {
-	    pixel_t average = pixel;
-	    int sum_r, sum_g, sum_b,
-		m = 1, n = MIN_SAMPLES;
-	    sum_r = pixel_get_r(pixel);
-	    sum_g = pixel_get_g(pixel);
-	    sum_b = pixel_get_b(pixel);
-	    do {
-		pixel = average;
-		for (int k = m; k < n; k++) {	// pixel refinement with MC integration
-		    double p_r = c_r + d * ((x + dx[k]) - width  / 2),
-			   p_i = c_i + d * (height / 2 - (y + dy[k]));
-		    int   iter = mandelbrot(iter_max, p_r, p_i);
-		    sum_r += pixel_get_r(colormap[iter & iter_mask]);
-		    sum_g += pixel_get_g(colormap[iter & iter_mask]);
-		    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+    rough_sketch(sketch, dist, colormap, iter_max, c_r, c_i, radius, sched);
+
+    // sketch rows of the other PEs in the group are needed to detect edges.
+    rows_gather(sketch->data, (size_t) width * sizeof(pixel_t), sched, true);
+#ifdef USE_DISTANCE_ESTIMATOR
+    rows_gather(dist        , (size_t) width * sizeof(float  ), sched, true);
+#endif
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    pixel_t pixel;
+#ifdef USE_DISTANCE_ESTIMATOR
+		    pixmap_get_pixel(sketch, &pixel, x, y);
+		    if (near_boundary(dist, width, height, x, y)) {
+#else
+		    if (detect_edge(sketch, &pixel, x, y)) {
+#endif
+			pixel_t average = pixel;
+			int sum_r, sum_g, sum_b,
+			    m = 1, n = MIN_SAMPLES;
+			sum_r = pixel_get_r(pixel);
+			sum_g = pixel_get_g(pixel);
+			sum_b = pixel_get_b(pixel);
+			do {
+			    pixel = average;
+			    for (int k = m; k < n; k++) {	// pixel refinement with MC integration
+				double p_r = c_r + d * ((x + dx[k]) - width  / 2),
+				       p_i = c_i + d * (height / 2 - (y + dy[k]));
+				int   iter = mandelbrot(iter_max, p_r, p_i);
+				sum_r += pixel_get_r(colormap[iter & iter_mask]);
+				sum_g += pixel_get_g(colormap[iter & iter_mask]);
+				sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			    }
+			    average = pixel_set_rgb(ROUND((double) sum_r / n),
+						    ROUND((double) sum_g / n),
+						    ROUND((double) sum_b / n));
+			} while (!equivalent_color(average, pixel) &&
+				    (n = (m = n) << 0x01) <= MAX_SAMPLES);
+			pixel = average;
+		    }
+		    pixmap_put_pixel(image, pixel, x, y);
 		}
-		average = pixel_set_rgb(ROUND((double) sum_r / n),
-					ROUND((double) sum_g / n),
-					ROUND((double) sum_b / n));
-	    } while (!equivalent_color(average, pixel) &&
-			(n = (m = n) << 0x01) <= MAX_SAMPLES);
-	    pixel = average;
-	}
-	pixmap_put_pixel(image, pixel, x, y);
     }
 
     return;
 }
 
 //----------------------------------------------------------------------
-void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
-		int iter_max, double c_r, double c_i, double radius)
+void rough_sketch(pixmap_t *sketch, float *dist, pixel_t *colormap,
+		int iter_max, double c_r, double c_i, double radius, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
     int width, height;
@@ -148,14 +524,25 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap,
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = 0;  xy < width * height; xy++) {
-	int    x   = xy % width,
-	       y   = xy / width;
-	double p_r = c_r + d * (x - width  / 2),
-	       p_i = c_i + d * (height / 2 - y);
-	int   iter = mandelbrot(iter_max, p_r, p_i);
-	pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	while (tile_sched_next(sched, &tile))
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    double p_r = c_r + d * (x - width  / 2),
+			   p_i = c_i + d * (height / 2 - y);
+#ifdef USE_DISTANCE_ESTIMATOR
+		    double  de;
+		    int   iter = mandelbrot_de(iter_max, p_r, p_i, &de);
+		    dist[(size_t) y * width + x] = (float) (de / d);
+#else
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+#endif
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+		}
     }
 
     return;
@@ -181,6 +568,47 @@ int mandelbrot(int iter_max, double p_r, double p_i)
     return i;
 }
 
+//----------------------------------------------------------------------
+int mandelbrot_de(int iter_max, double p_r, double p_i, double *de)
+{				// kernel function with exterior distance estimation
+    int i;
+    double z_r, z_i, dz_r, dz_i, work;
+
+    z_r  = p_r;			// z     = c
+    z_i  = p_i;
+    dz_r = 1.0;			// dz/dc = 1
+    dz_i = 0.0;
+
+    for (i = 1; i < iter_max && z_r * z_r + z_i * z_i < 4.0; i++) {
+	work = 2.0 * (z_r * dz_r - z_i * dz_i) + 1.0;
+	dz_i = 2.0 * (z_r * dz_i + z_i * dz_r);
+	dz_r = work;
+	work = 2.0 * z_r * z_i;
+	z_r  = z_r * z_r + (p_r - z_i * z_i);
+	z_i  = p_i + work;
+    }
+
+    if (i >= iter_max) {	// interior point: distance is zero.
+	*de = 0.0;
+	return i;
+    }
+
+    while (z_r * z_r + z_i * z_i < DE_BAILOUT) {	// improve accuracy of estimation
+	work = 2.0 * (z_r * dz_r - z_i * dz_i) + 1.0;
+	dz_i = 2.0 * (z_r * dz_i + z_i * dz_r);
+	dz_r = work;
+	work = 2.0 * z_r * z_i;
+	z_r  = z_r * z_r + (p_r - z_i * z_i);
+	z_i  = p_i + work;
+    }
+
+    work = sqrt(z_r  * z_r  + z_i  * z_i );
+    *de  = work * log(work) /
+	   sqrt(dz_r * dz_r + dz_i * dz_i);
+
+    return i;
+}
+
 //----------------------------------------------------------------------
 bool detect_edge(pixmap_t *pixmap, pixel_t *pixel, int x, int y)
 {
@@ -201,6 +629,20 @@ bool detect_edge(pixmap_t *pixmap, pixel_t *pixel, int x, int y)
     return false;
 }
 
+//----------------------------------------------------------------------
+bool near_boundary(float *dist, int width, int height, int x, int y)
+{				// edge detection with distance estimation
+    if (dist[(size_t) y * width + x] > 0.0f)	// exterior point
+	return dist[(size_t) y * width + x] < DE_THRESHOLD;
+
+    for (int j = MAX(0, y - 1); j <= MIN(height - 1, y + 1); j++)
+	for (int i = MAX(0, x - 1); i <= MIN(width - 1, x + 1); i++)
+	    if (dist[(size_t) j * width + i] > 0.0f)	// interior point next to exterior one
+		return true;
+
+    return false;
+}
+
 //----------------------------------------------------------------------
 bool equivalent_color(pixel_t p, pixel_t q)
 #ifdef USE_SAME_COLOR
@@ -2,10 +2,43 @@
 # config.mk
 # $Id: config.mk,v 1.1.1.1 2015/02/26 00:00:00 seiji Exp seiji $
 #=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+# EDGE  : edge detection method [color|distance]
+#........................................................................
+EDGE	= color
+#------------------------------------------------------------------------
 # EQVCLR: equivalent color detection [relaxed|strict]
 #........................................................................
 EQVCLR	= relaxed
 #------------------------------------------------------------------------
+# MPIDIST: MPI work distribution [block|halo|weighted|dynamic|cyclic]
+#          block   : contiguous row blocks, gathered with MPI_(All)Gatherv
+#          halo    : contiguous row blocks, sketch exchanged with neighbours
+#          weighted: row blocks of equal cost estimated from the sketch
+#          dynamic : tiles on demand from a counter on PE0 (MPI-3 RMA)
+#          cyclic  : round-robin tiles, reduced with MPI_Allreduce(BOR)
+#........................................................................
+MPIDIST	= block
+#------------------------------------------------------------------------
+# OUTPUT: image output [posix|mpiio]
+#         posix: PE0 writes the image gathered from all PEs
+#         mpiio: PEs write their own row blocks (MPI_File_write_at_all)
+#         (MPIDIST=block|halo|weighted)
+#........................................................................
+OUTPUT	= posix
+#------------------------------------------------------------------------
+# OVERLAP: ship finished image bands to PE0 while rendering [no|yes|thread]
+#          yes   : the master thread also renders tiles
+#          thread: the master thread is dedicated to MPI progress
+#          (MPIDIST=block|halo|weighted)
+#........................................................................
+OVERLAP	= no
+#------------------------------------------------------------------------
+# DIAG  : load balance diagnostics of threads and PEs [none|report|csv]
+#         report: min/avg/max of compute/wait/comm time, worst tiles
+#         csv   : report, and time of each thread written into diag.csv
+#........................................................................
+DIAG	= none
+#------------------------------------------------------------------------
 # DATA  : input data set [input/$(DATA).dat]
 #........................................................................
 DATA	= 001
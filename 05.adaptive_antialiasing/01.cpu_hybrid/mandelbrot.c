@@ -8,17 +8,40 @@
 #include <mpi.h>
 #endif
 
+#ifdef USE_MPIIO_OUTPUT
+#include <ppm_io.h>
+#endif
+
+#ifdef USE_DYNAMIC_DIST
+#include <wtime.h>
+#endif
+
+#if defined(_OPENMP) && defined(USE_PROGRESS_THREAD)
+#include <omp.h>
+#endif
+
+#ifdef USE_LB_STAT
+#include <lb_stat.h>
+#endif
+
 #include <time.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 // for adaptive anti-aliasing
 #define MIN_SAMPLES	(0x01<<4)
 #define MAX_SAMPLES	(0x01<<16)
 
+// for distance estimator based edge detection
+#define DE_THRESHOLD	1.0	// refinement threshold [pixel pitch]
+#define DE_BAILOUT	1.E6	// bailout value of |z|^2 for distance estimation
+
 #define ROUND(x)	((int) round(x))
 #define MIN(x,y)	(((x)<(y))?(x):(y))
 #define MAX(x,y)	(((x)>(y))?(x):(y))
@@ -27,51 +50,203 @@
 #define SRAND(s)	srand(s)
 #define DRAND()		((double) rand()/(RAND_MAX+1.0))
 
+// thread support level of MPI required by threads calling MPI functions
+#if   defined(USE_DYNAMIC_DIST)	// threads take tiles from the shared counter one by one.
+#define REQUIRED_THREAD_LEVEL	MPI_THREAD_SERIALIZED
+#elif defined(USE_OVERLAP_COMM)	// the master thread ships image bands while rendering.
+#define REQUIRED_THREAD_LEVEL	MPI_THREAD_FUNNELED
+#endif
+
+// load balance diagnostics: time of each thread is charged to
+// computation of tiles, waiting for others or communication.
+#ifdef USE_LB_STAT
+#ifndef LB_STAT_CSV
+#define LB_STAT_CSV	NULL
+#endif
+#define LB_MARK()	lb_stat_mark(&lb)
+#define LB_LAP(k)	lb_stat_lap (&lb, k)
+#define LB_TILE(t)	lb_stat_tile(&lb, t)
+#define LB_SYNC()	lb_stat_sync(&lb)
+#define LB_BARRIER()	_Pragma("omp barrier") lb_stat_lap(&lb, LB_WAIT)
+static lb_stat_t lb;
+#else
+#define LB_MARK()
+#define LB_LAP(k)
+#define LB_TILE(t)
+#define LB_SYNC()
+#define LB_BARRIER()
+#endif
+
+#ifdef USE_DYNAMIC_DIST
+typedef struct {		// tile counter on PE0, shared among PEs
+    MPI_Win win;
+    int    *count, myrank;
+} tile_counter_t;
+#endif
+
+#ifdef USE_OVERLAP_COMM
+typedef struct {		// bands (rows of tiles) of image shipped to PE0 while rendering
+    int          y_head, y_tail;	// row block of this PE
+    int          num_bands;	// # of bands of this PE
+    int         *remain;	// # of tiles left to be rendered in each band
+    bool        *posted;	// band is shipped (or in place on PE0)
+    int          num_posted;
+    int          num_reqs;	// # of requests: receives on PE0, sends on others
+    int         *index;
+    MPI_Request *req;
+    int          myrank;
+} ship_t;
+#endif
+
 // prototypes
 void colormap_init   (pixel_t *, int);
 void jitter_init     (double *, double *);
-void draw_image      (pixmap_t *, pixmap_t *, pixel_t *,
-			int, double, double, double, double *, double *, int, int);
-void rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double, int, int);
+void draw_image      (pixmap_t *, pixmap_t *, float *, long *, pixel_t *,
+			int, double, double, double, double *, double *, int, int, tile_sched_t *);
+void rough_sketch    (pixmap_t *,             float *, long *, pixel_t *, int, double, double, double, int, int, tile_sched_t *);
 void pixmap_reduction(pixmap_t *, int, int);
+void dist_reduction  (float    *, int, int, int, int);
+void block_range     (int, int, int, int *, int *);
+void pixmap_gather   (pixmap_t *, bool, int, int, int, int);
+void dist_gather     (float    *, int, int, int, int);
+void cost_partition  (pixmap_t *, float *, long *, int *, int, int);
+#ifdef USE_DYNAMIC_DIST
+void tile_counter_create(tile_counter_t *, int);
+void tile_counter_free  (tile_counter_t *);
+int  tile_counter_fetch (void *);
+void tile_counter_reset (void *);
+void load_report     (double, int, int);
+#endif
+#ifdef USE_OVERLAP_COMM
+void ship_init       (ship_t *, pixmap_t *, tile_sched_t *, int, int);
+void ship_fin        (ship_t *, pixmap_t *);
+void ship_tile       (ship_t *, tile_t *);
+bool ship_progress   (ship_t *, pixmap_t *);
+#endif
+void halo_range      (int, int, int, int *, int *);
+void halo_exchange   (void *, size_t, tile_sched_t *, int);
 int  mandelbrot      (int, double, double);
+int  mandelbrot_de   (int, double, double, double *);
 bool detect_edge     (pixmap_t *, pixel_t *, int, int);
+bool near_boundary   (float    *, int, int, int, int);
 bool equivalent_color(pixel_t, pixel_t);
 
 //======================================================================
 int main(int argc, char **argv)
 {
-    int nprocs = 1, myrank = 0;
+    int nprocs = 1, myrank = 0, status = EXIT_SUCCESS;
+#ifdef USE_BLOCK_DIST
+    int y_head, y_tail;		// row block owned by this PE
+#endif
+    int h_head, h_tail;		// sketch rows held by this PE
+#ifdef REQUIRED_THREAD_LEVEL
+    int provided;
+#endif
+#ifdef USE_DYNAMIC_DIST
+    tile_counter_t counter;
+#endif
     pixmap_t image, sketch;
     pixel_t  colormap[ITER_MAX];
+    tile_sched_t sched;
     double   dx[MAX_SAMPLES],
 	     dy[MAX_SAMPLES];
+    float   *dist = NULL;	// distance estimation map [pixel pitch]
+    long    *escape = NULL;	// sum of escape counts in each row of sketch
 
 #ifdef USE_MPI
+#ifdef REQUIRED_THREAD_LEVEL
+    MPI_Init_thread(&argc, &argv, REQUIRED_THREAD_LEVEL, &provided);
+#else
     MPI_Init(&argc, &argv);
+#endif
     MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
 #endif
 
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
+#ifdef REQUIRED_THREAD_LEVEL
+    if (provided < REQUIRED_THREAD_LEVEL) {
+	if (myrank == 0)
+	    fprintf(stderr, "%s: required thread support of MPI is not available.\n", argv[0]);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+#endif
+
+#ifdef USE_LB_STAT
+    lb_stat_init(&lb);
+#endif
+
+#if   defined(USE_BLOCK_DIST)
+    block_range(HEIGHT, nprocs, myrank, &y_head, &y_tail);
+#if defined(USE_MPI) && defined(USE_HALO_DIST)
+    if (HEIGHT < nprocs) {	// halo exchange assumes non-empty row blocks.
+	if (myrank == 0)
+	    fprintf(stderr, "%s: too many PEs for the halo exchange.\n", argv[0]);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+#endif
+    tile_sched_init_rows(&sched, WIDTH, HEIGHT, y_head, y_tail);
+#elif defined(USE_DYNAMIC_DIST)
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);	// all tiles, dealt to PEs on demand
+    tile_counter_create(&counter, myrank);
+    tile_sched_set_source(&sched, tile_counter_fetch, tile_counter_reset, &counter);
+#else
+    tile_sched_init(&sched, WIDTH, HEIGHT, nprocs, myrank);
+#endif
+    halo_range(HEIGHT, sched.y_head, sched.y_tail, &h_head, &h_tail);
+    pixmap_allocate(&image , WIDTH, HEIGHT);
+    pixmap_allocate(&sketch, WIDTH, h_tail - h_head);
+    tile_sched_first_touch(&sched, image .data, sizeof(pixel_t));
+#ifndef USE_HALO_DIST		// otherwise, first-touched by rough_sketch().
+    tile_sched_first_touch(&sched, sketch.data, sizeof(pixel_t));
+#endif
+#ifdef USE_DISTANCE_ESTIMATOR
+    if ((dist = (float *) malloc((size_t) WIDTH * (h_tail - h_head) * sizeof(float))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+#ifndef USE_HALO_DIST
+    tile_sched_first_touch(&sched, dist, sizeof(float));
+#endif
+#endif
+#ifdef USE_WEIGHTED_DIST
+    if ((escape = (long *) malloc(HEIGHT * sizeof(long))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+#endif
     colormap_init(colormap, ITER_MAX);
     jitter_init(dx, dy);
 
-    draw_image(&image, &sketch, colormap,
-		ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy, nprocs, myrank);
+    draw_image(&image, &sketch, dist, escape, colormap,
+		ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy, nprocs, myrank, &sched);
 
+#ifdef USE_MPIIO_OUTPUT		// each PE writes its own row block.
+    status = ppm_io_write_rows("output.ppm", WIDTH, HEIGHT, sched.y_head, sched.y_tail,
+			       image.data + (size_t) sched.y_head * WIDTH);
+    if (status != EXIT_SUCCESS && myrank == 0)	// the status is the same on all PEs.
+	fprintf(stderr, "%s: cannot write output.ppm.\n", argv[0]);
+#else
     if (myrank == 0)
 	pixmap_write_ppmfile(&image, "output.ppm");
+#endif
 
+    free(escape);
+    free(dist);
     pixmap_destroy(&sketch);
     pixmap_destroy(&image );
+    tile_sched_fin(&sched);
+#ifdef USE_DYNAMIC_DIST
+    tile_counter_free(&counter);
+#endif
+#ifdef USE_LB_STAT
+    lb_stat_fin(&lb);
+#endif
 
 #ifdef USE_MPI
     MPI_Finalize();
 #endif
 
-    return EXIT_SUCCESS;
+    return status;
 }
 
 //----------------------------------------------------------------------
@@ -107,83 +282,317 @@ void jitter_init(double *dx, double *dy)
 }
 
 //----------------------------------------------------------------------
-void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap, int iter_max,
-	double c_r, double c_i, double radius, double *dx, double *dy, int nprocs, int myrank)
+void draw_image(pixmap_t *image, pixmap_t *sketch, float *dist, long *escape, pixel_t *colormap, int iter_max,
+	double c_r, double c_i, double radius, double *dx, double *dy, int nprocs, int myrank, tile_sched_t *sched)
 {				// adaptive anti-aliasing
     int iter_mask = iter_max - 1;
-    int width, height;
+    int width, height, h_head, h_tail;
     double d;
+#ifdef USE_OVERLAP_COMM
+    ship_t ship;
+#endif
+#ifdef USE_DYNAMIC_DIST
+    double ts, te;
+#endif
 
     pixmap_get_size(image, &width, &height);
+    halo_range(height, sched->y_head, sched->y_tail, &h_head, &h_tail);
 
     d = 2.0 * radius / MIN(width, height);
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius, nprocs, myrank);
-
-#pragma omp parallel for schedule(static,1)
-    for (int xy = myrank; xy < width * height; xy += nprocs) {
-	int x = xy % width,
-	    y = xy / width;
-	pixel_t pixel;
-	if (detect_edge(sketch, &pixel, x, y)) {
-	    pixel_t average = pixel;
-	    int sum_r, sum_g, sum_b,
-		m = 1, n = MIN_SAMPLES;
-	    sum_r = pixel_get_r(pixel);
-	    sum_g = pixel_get_g(pixel);
-	    sum_b = pixel_get_b(pixel);
-	    do {
-		pixel = average;
-		for (int k = m; k < n; k++) {	// pixel refinement with MC integration
-		    double p_r = c_r + d * ((x + dx[k]) - width  / 2),
-			   p_i = c_i + d * (height / 2 - (y + dy[k]));
-		    int   iter = mandelbrot(iter_max, p_r, p_i);
-		    sum_r += pixel_get_r(colormap[iter & iter_mask]);
-		    sum_g += pixel_get_g(colormap[iter & iter_mask]);
-		    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+    rough_sketch(sketch, dist, escape, colormap, iter_max, c_r, c_i, radius, nprocs, myrank, sched);
+
+#ifdef USE_WEIGHTED_DIST
+    {				// re-partition rows for refinement by estimated cost.
+	int y_part[nprocs + 1];
+	cost_partition(sketch, dist, escape, y_part, nprocs, myrank);
+	tile_sched_fin      (sched);
+	tile_sched_init_rows(sched, width, height, y_part[myrank], y_part[myrank + 1]);
+    }
+#endif
+
+#ifdef USE_DYNAMIC_DIST
+    ts = wtime(true);
+#endif
+
+#ifdef USE_OVERLAP_COMM
+    ship_init(&ship, image, sched, nprocs, myrank);
+#endif
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	LB_MARK();
+#if defined(_OPENMP) && defined(USE_PROGRESS_THREAD)
+	if (omp_get_thread_num() == 0 && omp_get_num_threads() > 1)
+	    while (ship_progress(&ship, image))	// dedicated to MPI progress
+		;
+	else
+#endif
+	while (tile_sched_next(sched, &tile)) {
+	    LB_LAP(LB_COMM);
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    pixel_t pixel;
+#ifdef USE_DISTANCE_ESTIMATOR
+		    pixmap_get_pixel(sketch, &pixel, x, y - h_head);
+		    if (near_boundary(dist, width, h_tail - h_head, x, y - h_head)) {
+#else
+		    if (detect_edge(sketch, &pixel, x, y - h_head)) {
+#endif
+			pixel_t average = pixel;
+			int sum_r, sum_g, sum_b,
+			    m = 1, n = MIN_SAMPLES;
+			sum_r = pixel_get_r(pixel);
+			sum_g = pixel_get_g(pixel);
+			sum_b = pixel_get_b(pixel);
+			do {
+			    pixel = average;
+			    for (int k = m; k < n; k++) {	// pixel refinement with MC integration
+				double p_r = c_r + d * ((x + dx[k]) - width  / 2),
+				       p_i = c_i + d * (height / 2 - (y + dy[k]));
+				int   iter = mandelbrot(iter_max, p_r, p_i);
+				sum_r += pixel_get_r(colormap[iter & iter_mask]);
+				sum_g += pixel_get_g(colormap[iter & iter_mask]);
+				sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			    }
+			    average = pixel_set_rgb(ROUND((double) sum_r / n),
+						    ROUND((double) sum_g / n),
+						    ROUND((double) sum_b / n));
+			} while (!equivalent_color(average, pixel) &&
+				    (n = (m = n) << 0x01) <= MAX_SAMPLES);
+			pixel = average;
+		    }
+		    pixmap_put_pixel(image, pixel, x, y);
 		}
-		average = pixel_set_rgb(ROUND((double) sum_r / n),
-					ROUND((double) sum_g / n),
-					ROUND((double) sum_b / n));
-	    } while (!equivalent_color(average, pixel) &&
-			(n = (m = n) << 0x01) <= MAX_SAMPLES);
-	    pixel = average;
+	    LB_TILE(&tile);
+#ifdef USE_OVERLAP_COMM
+	    ship_tile(&ship, &tile);
+#pragma omp master		// unless dedicated to MPI progress
+	    ship_progress(&ship, image);
+#endif
 	}
-	pixmap_put_pixel(image, pixel, x, y);
+	LB_LAP(LB_COMM);
+	LB_BARRIER();
     }
 
+#ifdef USE_DYNAMIC_DIST
+    te = wtime(false);		// busy time of this PE, before waiting for others
+#endif
+
+    LB_SYNC();
+#if   defined(USE_OVERLAP_COMM)
+    ship_fin(&ship, image);
+#elif defined(USE_MPIIO_OUTPUT)	// no gather, row blocks are written by their owners.
+#elif defined(USE_BLOCK_DIST)
+    pixmap_gather(image , false, sched->y_head, sched->y_tail, nprocs, myrank);
+#else
     pixmap_reduction(image, nprocs, myrank);
+#endif
+    LB_LAP(LB_COMM);
+
+#ifdef USE_DYNAMIC_DIST
+    load_report(te - ts, nprocs, myrank);
+#endif
+
+#ifdef USE_LB_STAT
+    lb_stat_report(&lb, LB_STAT_CSV);
+#endif
 
     return;
 }
 
 //----------------------------------------------------------------------
-void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
-	double c_r, double c_i, double radius, int nprocs, int myrank)
+void rough_sketch(pixmap_t *sketch, float *dist, long *escape, pixel_t *colormap, int iter_max,
+	double c_r, double c_i, double radius, int nprocs, int myrank, tile_sched_t *sched)
 {
     int iter_mask = iter_max - 1;
-    int width, height;
+    int width, height, h_head, h_tail;
     double d;
 
-    pixmap_get_size(sketch, &width, &height);
+    width  = sched->width ;	// sketch may hold only a part of rows.
+    height = sched->height;
+    halo_range(height, sched->y_head, sched->y_tail, &h_head, &h_tail);
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = myrank; xy < width * height; xy += nprocs) {
-	int x = xy % width,
-	    y = xy / width;
-	double p_r = c_r + d * (x - width  / 2),
-	       p_i = c_i + d * (height / 2 - y);
-	int   iter = mandelbrot(iter_max, p_r, p_i);
-	pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+    if (escape != NULL)
+	memset(escape, 0x00, height * sizeof(long));
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	LB_MARK();
+	while (tile_sched_next(sched, &tile)) {
+	    LB_LAP(LB_COMM);
+	    for (int y = tile.y; y < tile.y + tile.height; y++) {
+		long sum = 0;
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    double p_r = c_r + d * (x - width  / 2),
+			   p_i = c_i + d * (height / 2 - y);
+#ifdef USE_DISTANCE_ESTIMATOR
+		    double  de;
+		    int   iter = mandelbrot_de(iter_max, p_r, p_i, &de);
+		    dist[(size_t) (y - h_head) * width + x] = (float) (de / d);
+#else
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+#endif
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y - h_head);
+		    sum += iter;
+		}
+		if (escape != NULL) {
+#pragma omp atomic
+		    escape[y] += sum;
+		}
+	    }
+	    LB_TILE(&tile);
+	}
+	LB_LAP(LB_COMM);
+	LB_BARRIER();
     }
 
+    LB_SYNC();
+#if   defined(USE_HALO_DIST)
+    halo_exchange(sketch->data, width * SIZEOF_PIXEL_T, sched, myrank);
+#ifdef USE_DISTANCE_ESTIMATOR
+    halo_exchange(dist, width * sizeof(float), sched, myrank);
+#endif
+#elif defined(USE_BLOCK_DIST)
+    pixmap_gather(sketch, true , sched->y_head, sched->y_tail, nprocs, myrank);
+#ifdef USE_DISTANCE_ESTIMATOR
+    dist_gather(dist, width, height, nprocs, myrank);
+#endif
+#else
     pixmap_reduction(sketch, nprocs, myrank);
+#ifdef USE_DISTANCE_ESTIMATOR
+    dist_reduction(dist, width, height, nprocs, myrank);
+#endif
+#endif
+    LB_LAP(LB_COMM);
+
+    return;
+}
+
+#ifdef USE_OVERLAP_COMM
+//----------------------------------------------------------------------
+void ship_init(ship_t *ship, pixmap_t *image, tile_sched_t *sched, int nprocs, int myrank)
+{				// collective: PE0 posts receives of all bands of other PEs
+				// in place, sends are posted as bands are rendered.
+    int width, height, range[2] = { sched->y_head, sched->y_tail }, *rows;
+
+    pixmap_get_size(image, &width, &height);
+
+    ship->y_head     = sched->y_head;
+    ship->y_tail     = sched->y_tail;
+    ship->num_bands  = (ship->y_tail - ship->y_head + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    ship->num_posted = 0;
+    ship->num_reqs   = 0;
+    ship->myrank     = myrank;
+
+    if ((rows = (int *) malloc(2 * nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // row blocks of all PEs
+    MPI_Allgather(range, 2, MPI_INT, rows, 2, MPI_INT, MPI_COMM_WORLD);
+
+    if (myrank == 0)
+	for (int p = 1; p < nprocs; p++)
+	    ship->num_reqs += (rows[2 * p + 1] - rows[2 * p] + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    else
+	ship->num_reqs  = ship->num_bands;
+
+    // a PE may have no bands, and PE0 has no receives if nprocs == 1.
+    if ((ship->remain = (int         *) malloc(MAX(1, ship->num_bands) * sizeof(int        ))) == NULL ||
+	(ship->posted = (bool        *) malloc(MAX(1, ship->num_bands) * sizeof(bool       ))) == NULL ||
+	(ship->index  = (int         *) malloc(MAX(1, ship->num_reqs ) * sizeof(int        ))) == NULL ||
+	(ship->req    = (MPI_Request *) malloc(MAX(1, ship->num_reqs ) * sizeof(MPI_Request))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int b = 0; b < ship->num_bands; b++) {
+	ship->remain[b] = sched->num_tiles_x;
+	ship->posted[b] = false;
+    }
+
+    if (myrank == 0)		// bands of PE p are tagged with their indices in the block.
+	for (int p = 1, k = 0; p < nprocs; p++)
+	    for (int y = rows[2 * p]; y < rows[2 * p + 1]; y += TILE_HEIGHT)
+		MPI_Irecv(image->data + (size_t) y * width,
+			  MIN(TILE_HEIGHT, rows[2 * p + 1] - y) * width * SIZEOF_PIXEL_T, MPI_BYTE,
+			  p, (y - rows[2 * p]) / TILE_HEIGHT, MPI_COMM_WORLD, &ship->req[k++]);
+
+    free(rows);
 
     return;
 }
 
+//----------------------------------------------------------------------
+void ship_fin(ship_t *ship, pixmap_t *image)
+{				// collective: ship the rest of bands, and wait for completion.
+    ship_progress(ship, image);
+    MPI_Waitall(ship->num_reqs, ship->req, MPI_STATUSES_IGNORE);
+
+    free(ship->req   );
+    free(ship->index );
+    free(ship->posted);
+    free(ship->remain);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void ship_tile(ship_t *ship, tile_t *tile)
+{				// a tile has been rendered (by any thread).
+    int b = (tile->y - ship->y_head) / TILE_HEIGHT;
+
+    // seq_cst implies a flush, pixels of the tile are visible to the master thread.
+#pragma omp atomic update seq_cst
+    ship->remain[b]--;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+bool ship_progress(ship_t *ship, pixmap_t *image)
+{				// master thread only (MPI_THREAD_FUNNELED): post sends of rendered
+				// bands, and drive pending requests.
+				// return true while some bands are left to be rendered.
+    int width = image->width, active, count;
+
+    for (int b = 0; b < ship->num_bands; b++)
+	if (!ship->posted[b]) {
+	    int remain;
+#pragma omp atomic read seq_cst
+	    remain = ship->remain[b];
+	    if (remain == 0) {
+		if (ship->myrank != 0) {
+		    int y = ship->y_head + b * TILE_HEIGHT;
+		    MPI_Isend(image->data + (size_t) y * width,
+			      MIN(TILE_HEIGHT, ship->y_tail - y) * width * SIZEOF_PIXEL_T, MPI_BYTE,
+			      0, b, MPI_COMM_WORLD, &ship->req[ship->num_posted]);
+		}
+		ship->posted[b] = true;
+		ship->num_posted++;
+	    }
+	}
+
+    // receives on PE0 are all posted in advance.
+    active = (ship->myrank == 0) ? ship->num_reqs : ship->num_posted;
+
+    if (active > 0)
+	MPI_Testsome(active, ship->req, &count, ship->index, MPI_STATUSES_IGNORE);
+
+    return ship->num_posted < ship->num_bands;
+}
+#endif
+
 //----------------------------------------------------------------------
 void pixmap_reduction(pixmap_t *pixmap, int nprocs, int myrank)
 {
@@ -199,6 +608,306 @@ void pixmap_reduction(pixmap_t *pixmap, int nprocs, int myrank)
     return;
 }
 
+//----------------------------------------------------------------------
+void dist_reduction(float *dist, int width, int height, int nprocs, int myrank)
+{
+#ifdef USE_MPI
+    // distance is positive on exterior points and zero elsewhere.
+    MPI_Allreduce(MPI_IN_PLACE, dist, width * height,
+		  MPI_FLOAT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void block_range(int height, int nprocs, int rank, int *y_head, int *y_tail)
+{				// row block [y_head:y_tail) owned by a PE.
+    *y_head = (long) height *  rank      / nprocs;
+    *y_tail = (long) height * (rank + 1) / nprocs;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void cost_partition(pixmap_t *sketch, float *dist, long *escape, int *y_part, int nprocs, int myrank)
+{				// partition rows into contiguous ranges [y_part[p]:y_part[p+1])
+				// of equal refinement cost estimated from the whole sketch:
+				// # of edge pixels weighted by the mean escape count of
+				// neighbourhood rows.
+    int width, height, p = 1;
+    double *cost, total = 0.0, prefix = 0.0,
+	   max_block = 0.0, max_part = 0.0;
+
+    pixmap_get_size(sketch, &width, &height);
+
+    if ((cost = (double *) malloc(height * sizeof(double))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, escape, height, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+#pragma omp parallel for schedule(dynamic)
+    for (int y = 0; y < height; y++) {
+	long edges = 0, sum = 0, rows = 0;
+	for (int x = 0; x < width; x++) {
+#ifdef USE_DISTANCE_ESTIMATOR
+	    if (near_boundary(dist, width, height, x, y))
+#else
+	    pixel_t pixel;
+	    if (detect_edge(sketch, &pixel, x, y))
+#endif
+		edges++;
+	}
+	for (int j = MAX(0, y - 1); j <= MIN(height - 1, y + 1); j++, rows++)
+	    sum += escape[j];
+	cost[y] = 1.0 + (double) edges * sum / (rows * width);
+    }
+
+    for (int y = 0; y < height; y++)
+	total += cost[y];
+
+    y_part[0] = 0;
+    for (int y = 0; y < height && p < nprocs; y++) {
+	// cut before row y if the target is in its former half.
+	while (p < nprocs && total * p / nprocs <= prefix + 0.5 * cost[y])
+	    y_part[p++] = y;
+	prefix += cost[y];
+    }
+    while (p < nprocs)		// cuts left open after the last row
+	y_part[p++] = height;
+    y_part[nprocs] = height;
+
+#ifdef DEBUG
+    for (p = 0; p < nprocs; p++)
+	if (y_part[p] > y_part[p + 1]) {
+	    fprintf(stderr, "%s: cuts are not monotonic at #%d.\n", __func__, p);
+	    exit(EXIT_FAILURE);
+	}
+#endif
+
+    // estimated imbalance (max/avg) of equal-rows and weighted partitions
+    for (int p = 0; p < nprocs; p++) {
+	int    y_head, y_tail;
+	double c_block = 0.0, c_part = 0.0;
+	block_range(height, nprocs, p, &y_head, &y_tail);
+	for (int y = y_head   ; y < y_tail       ; y++)
+	    c_block += cost[y];
+	for (int y = y_part[p]; y < y_part[p + 1]; y++)
+	    c_part  += cost[y];
+	max_block = MAX(max_block, c_block);
+	max_part  = MAX(max_part , c_part );
+    }
+    if (myrank == 0)
+	printf("Imbalance(estimated)=%.3f(block) -> %.3f(weighted)\n",
+		max_block * nprocs / total, max_part * nprocs / total);
+
+    free(cost);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void pixmap_gather(pixmap_t *pixmap, bool all, int y_head, int y_tail, int nprocs, int myrank)
+{				// gather row blocks [y_head:y_tail) of pixmap image to PE0 (or all PEs).
+#ifdef USE_MPI
+    int width, height, range[2] = { y_head, y_tail },
+	*rows = NULL, *count = NULL, *displ = NULL;
+
+    pixmap_get_size(pixmap, &width, &height);
+
+    if ((rows  = (int *) malloc(2 * nprocs * sizeof(int))) == NULL ||
+	(count = (int *) malloc(    nprocs * sizeof(int))) == NULL ||
+	(displ = (int *) malloc(    nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // row blocks of all PEs
+    MPI_Allgather(range, 2, MPI_INT, rows, 2, MPI_INT, MPI_COMM_WORLD);
+
+    for (int p = 0; p < nprocs; p++) {
+	count[p] = (rows[2 * p + 1] - rows[2 * p]) * width * SIZEOF_PIXEL_T;
+	displ[p] =  rows[2 * p]                    * width * SIZEOF_PIXEL_T;
+    }
+
+    if (all)
+	MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		       pixmap->data, count, displ, MPI_BYTE, MPI_COMM_WORLD);
+    else
+	MPI_Gatherv((myrank == 0) ? MPI_IN_PLACE : (char *) pixmap->data + displ[myrank],
+		    count[myrank], MPI_BYTE,
+		    pixmap->data, count, displ, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    free(displ);
+    free(count);
+    free(rows );
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void dist_gather(float *dist, int width, int height, int nprocs, int myrank)
+{				// gather row blocks of distance estimation map to all PEs.
+#ifdef USE_MPI
+    int *count, *displ;
+
+    if ((count = (int *) malloc(nprocs * sizeof(int))) == NULL ||
+	(displ = (int *) malloc(nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int p = 0; p < nprocs; p++) {
+	int y_head, y_tail;
+	block_range(height, nprocs, p, &y_head, &y_tail);
+	count[p] = (y_tail - y_head) * width;
+	displ[p] =  y_head           * width;
+    }
+
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		   dist, count, displ, MPI_FLOAT, MPI_COMM_WORLD);
+
+    free(displ);
+    free(count);
+#endif
+
+    return;
+}
+
+#ifdef USE_DYNAMIC_DIST
+//----------------------------------------------------------------------
+void tile_counter_create(tile_counter_t *counter, int myrank)
+{				// collective: a tile counter is allocated on PE0.
+    MPI_Win_allocate((myrank == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL,
+		     MPI_COMM_WORLD, &counter->count, &counter->win);
+
+    if (myrank == 0)
+	*counter->count = 0;
+    counter->myrank = myrank;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, counter->win);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_counter_free(tile_counter_t *counter)
+{				// collective
+    MPI_Win_unlock_all(counter->win);
+    MPI_Win_free(&counter->win);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+int tile_counter_fetch(void *arg)
+{				// take next tile index by an atomic fetch-and-add on PE0.
+    tile_counter_t *counter = (tile_counter_t *) arg;
+    const int one = 1;
+    int k;
+
+#pragma omp critical (tile_counter)
+    {
+	MPI_Fetch_and_op(&one, &k, MPI_INT, 0, 0, MPI_SUM, counter->win);
+	MPI_Win_flush(0, counter->win);
+    }
+
+    return k;
+}
+
+//----------------------------------------------------------------------
+void tile_counter_reset(void *arg)
+{				// collective: rewind the counter between stages.
+				// all PEs have finished fetching of the previous stage.
+    tile_counter_t *counter = (tile_counter_t *) arg;
+    const int zero = 0;
+    int k;
+
+    if (counter->myrank == 0) {
+	MPI_Fetch_and_op(&zero, &k, MPI_INT, 0, 0, MPI_REPLACE, counter->win);
+	MPI_Win_flush(0, counter->win);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void load_report(double busy, int nprocs, int myrank)
+{				// report busy/idle time of PEs in rendering,
+				// idle time is spent waiting for the slowest PE.
+    double *t_busy = NULL, t_max = 0.0, t_sum = 0.0;
+
+    if (myrank == 0 &&
+	(t_busy = (double *) malloc(nprocs * sizeof(double))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Gather(&busy, 1, MPI_DOUBLE, t_busy, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (myrank == 0) {
+	for (int p = 0; p < nprocs; p++) {
+	    t_max  = MAX(t_max, t_busy[p]);
+	    t_sum +=            t_busy[p];
+	}
+	for (int p = 0; p < nprocs; p++)
+	    printf("PE%-4d: busy=%10.3f[sec.], idle=%10.3f[sec.]\n",
+					p, t_busy[p], t_max - t_busy[p]);
+	printf("Imbalance=%.3f (max/avg)\n", t_max * nprocs / t_sum);
+	free(t_busy);
+    }
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void halo_range(int height, int y_head, int y_tail, int *h_head, int *h_tail)
+{				// sketch rows [h_head:h_tail) held by a PE.
+#ifdef USE_HALO_DIST		// own row block and one-row halo
+    *h_head = MAX(0     , y_head - 1);
+    *h_tail = MIN(height, y_tail + 1);
+#else				// all rows
+    *h_head = 0;
+    *h_tail = height;
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void halo_exchange(void *data, size_t row_size, tile_sched_t *sched, int myrank)
+{				// exchange one-row halo of sketch data with neighbour PEs.
+#ifdef USE_MPI
+    int h_head, h_tail, upper, lower;
+    char *rows = (char *) data;
+
+    halo_range(sched->height, sched->y_head, sched->y_tail, &h_head, &h_tail);
+
+    upper = (h_head < sched->y_head) ? myrank - 1 : MPI_PROC_NULL;
+    lower = (h_tail > sched->y_tail) ? myrank + 1 : MPI_PROC_NULL;
+
+    // 1st own row to the upper PE, lower halo from the lower PE.
+    MPI_Sendrecv(rows + (size_t) (sched->y_head     - h_head) * row_size, row_size, MPI_BYTE, upper, 0,
+		 rows + (size_t) (h_tail            - h_head - 1) * row_size, row_size, MPI_BYTE, lower, 0,
+		 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    // last own row to the lower PE, upper halo from the upper PE.
+    MPI_Sendrecv(rows + (size_t) (sched->y_tail - 1 - h_head) * row_size, row_size, MPI_BYTE, lower, 1,
+		 rows,                                                    row_size, MPI_BYTE, upper, 1,
+		 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+#endif
+
+    return;
+}
+
 //----------------------------------------------------------------------
 int mandelbrot(int iter_max, double p_r, double p_i)
 {				// kernel function (scalar version)
@@ -219,6 +928,47 @@ int mandelbrot(int iter_max, double p_r, double p_i)
     return i;
 }
 
+//----------------------------------------------------------------------
+int mandelbrot_de(int iter_max, double p_r, double p_i, double *de)
+{				// kernel function with exterior distance estimation
+    int i;
+    double z_r, z_i, dz_r, dz_i, work;
+
+    z_r  = p_r;			// z     = c
+    z_i  = p_i;
+    dz_r = 1.0;			// dz/dc = 1
+    dz_i = 0.0;
+
+    for (i = 1; i < iter_max && z_r * z_r + z_i * z_i < 4.0; i++) {
+	work = 2.0 * (z_r * dz_r - z_i * dz_i) + 1.0;
+	dz_i = 2.0 * (z_r * dz_i + z_i * dz_r);
+	dz_r = work;
+	work = 2.0 * z_r * z_i;
+	z_r  = z_r * z_r + (p_r - z_i * z_i);
+	z_i  = p_i + work;
+    }
+
+    if (i >= iter_max) {	// interior point: distance is zero.
+	*de = 0.0;
+	return i;
+    }
+
+    while (z_r * z_r + z_i * z_i < DE_BAILOUT) {	// improve accuracy of estimation
+	work = 2.0 * (z_r * dz_r - z_i * dz_i) + 1.0;
+	dz_i = 2.0 * (z_r * dz_i + z_i * dz_r);
+	dz_r = work;
+	work = 2.0 * z_r * z_i;
+	z_r  = z_r * z_r + (p_r - z_i * z_i);
+	z_i  = p_i + work;
+    }
+
+    work = sqrt(z_r  * z_r  + z_i  * z_i );
+    *de  = work * log(work) /
+	   sqrt(dz_r * dz_r + dz_i * dz_i);
+
+    return i;
+}
+
 //----------------------------------------------------------------------
 bool detect_edge(pixmap_t *pixmap, pixel_t *pixel, int x, int y)
 {
@@ -239,6 +989,20 @@ bool detect_edge(pixmap_t *pixmap, pixel_t *pixel, int x, int y)
     return false;
 }
 
+//----------------------------------------------------------------------
+bool near_boundary(float *dist, int width, int height, int x, int y)
+{				// edge detection with distance estimation
+    if (dist[(size_t) y * width + x] > 0.0f)	// exterior point
+	return dist[(size_t) y * width + x] < DE_THRESHOLD;
+
+    for (int j = MAX(0, y - 1); j <= MIN(height - 1, y + 1); j++)
+	for (int i = MAX(0, x - 1); i <= MIN(width - 1, x + 1); i++)
+	    if (dist[(size_t) j * width + i] > 0.0f)	// interior point next to exterior one
+		return true;
+
+    return false;
+}
+
 //----------------------------------------------------------------------
 bool equivalent_color(pixel_t p, pixel_t q)
 #ifdef USE_SAME_COLOR
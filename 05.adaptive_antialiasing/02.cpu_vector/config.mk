@@ -24,6 +24,44 @@ SAMPLE	= hammersley
 #........................................................................
 VECTOR	= 0
 #------------------------------------------------------------------------
-# DATA  : input data set [input/$(DATA).dat]
+# MPIDIST: MPI work distribution [block|halo|weighted|dynamic|cyclic]
+#          block   : contiguous row blocks, gathered with MPI_(All)Gatherv
+#          halo    : contiguous row blocks, sketch exchanged with neighbours
+#          weighted: row blocks of equal cost estimated from the sketch
+#          dynamic : tiles on demand from a counter on PE0 (MPI-3 RMA)
+#          cyclic  : round-robin tiles, reduced with MPI_Allreduce(BOR)
+#........................................................................
+MPIDIST	= block
+#------------------------------------------------------------------------
+# OUTPUT: image output [posix|mpiio]
+#         posix: PE0 writes the image gathered from all PEs
+#         mpiio: PEs write their own row blocks (MPI_File_write_at_all)
+#         (MPIDIST=block|halo|weighted)
+#........................................................................
+OUTPUT	= posix
+#------------------------------------------------------------------------
+# SHMWIN: share data among PEs on a node by MPI-3 windows [yes|no]
+#         (MPIDIST=block only, node leaders do inter-node communication)
+#........................................................................
+SHMWIN	= no
+#------------------------------------------------------------------------
+# OVERLAP: ship finished image bands to PE0 while rendering [no|yes|thread]
+#          yes   : the master thread also renders tiles
+#          thread: the master thread is dedicated to MPI progress
+#          (MPIDIST=block|halo|weighted, SHMWIN=no)
+#........................................................................
+OVERLAP	= no
+#------------------------------------------------------------------------
+# BIND  : bind OpenMP threads to CPUs [yes|no]
+#........................................................................
+BIND	= no
+#------------------------------------------------------------------------
+# DIAG  : load balance diagnostics of threads and PEs [none|report|csv]
+#         report: min/avg/max of compute/wait/comm time, worst tiles
+#         csv   : report, and time of each thread written into diag.csv
+#........................................................................
+DIAG	= none
+#------------------------------------------------------------------------
+# DATA  : input data set [input/$(DATA).dat], benchmark* for timing
 #........................................................................
 DATA	= benchmark
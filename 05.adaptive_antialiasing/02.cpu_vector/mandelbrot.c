@@ -8,10 +8,26 @@
 #include <mpi.h>
 #endif
 
+#ifdef USE_MPIIO_OUTPUT
+#include <ppm_io.h>
+#endif
+
+#if defined(_OPENMP) && defined(USE_PROGRESS_THREAD)
+#include <omp.h>
+#endif
+
 #ifdef BENCHMARK_TEST
 #include <wtime.h>
 #endif
 
+#if defined(BENCHMARK_TEST) || defined(USE_THREAD_BINDING)
+#include <affinity.h>
+#endif
+
+#ifdef USE_LB_STAT
+#include <lb_stat.h>
+#endif
+
 #if   defined(USE_HALTON) || defined(USE_HAMMERSLEY)
 #include <lds.h>
 #elif defined(USE_MT19937)
@@ -22,8 +38,10 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pixmap.h>
 #include <palette.h>
+#include <tile_sched.h>
 #include <stdbool.h>
 
 // for adaptive anti-aliasing
@@ -62,13 +80,107 @@ typedef int  bool_t;
 #define TRUE	1
 #endif
 
+// thread support level of MPI required by threads calling MPI functions
+#if   defined(USE_DYNAMIC_DIST)	// threads take tiles from the shared counter one by one.
+#define REQUIRED_THREAD_LEVEL	MPI_THREAD_SERIALIZED
+#elif defined(USE_OVERLAP_COMM)	// the master thread ships image bands while rendering.
+#define REQUIRED_THREAD_LEVEL	MPI_THREAD_FUNNELED
+#endif
+
+// load balance diagnostics: time of each thread is charged to
+// computation of tiles, waiting for others or communication.
+#ifdef USE_LB_STAT
+#ifndef LB_STAT_CSV
+#define LB_STAT_CSV	NULL
+#endif
+#define LB_MARK()	lb_stat_mark(&lb)
+#define LB_LAP(k)	lb_stat_lap (&lb, k)
+#define LB_TILE(t)	lb_stat_tile(&lb, t)
+#define LB_SYNC()	lb_stat_sync(&lb)
+#define LB_BARRIER()	_Pragma("omp barrier") lb_stat_lap(&lb, LB_WAIT)
+static lb_stat_t lb;
+#else
+#define LB_MARK()
+#define LB_LAP(k)
+#define LB_TILE(t)
+#define LB_SYNC()
+#define LB_BARRIER()
+#endif
+
+#ifdef USE_DYNAMIC_DIST
+typedef struct {		// tile counter on PE0, shared among PEs
+    MPI_Win win;
+    int    *count, myrank;
+} tile_counter_t;
+#endif
+
+#ifdef USE_OVERLAP_COMM
+typedef struct {		// bands (rows of tiles) of image shipped to PE0 while rendering
+    int          y_head, y_tail;	// row block of this PE
+    int          num_bands;	// # of bands of this PE
+    int         *remain;	// # of tiles left to be rendered in each band
+    bool        *posted;	// band is shipped (or in place on PE0)
+    int          num_posted;
+    int          num_reqs;	// # of requests: receives on PE0, sends on others
+    int          num_done;	// # of requests completed so far
+    int         *index;
+    MPI_Request *req;
+    int          myrank;
+} ship_t;
+#endif
+
+#ifdef USE_SHARED_WIN
+#define NODE_MAX_WINS	8
+
+typedef struct {		// PEs on a shared-memory node
+    MPI_Comm comm, leader;	// intra-node comm. and comm. of node leaders
+				// (leader is MPI_COMM_NULL except on leaders.)
+    int      rank, size;	// rank in node, # of PEs in node
+    int      first;		// position of node's 1st PE in node-major order
+    int      num_wins;
+    MPI_Win  win[NODE_MAX_WINS];
+} node_t;
+
+static node_t node;		// node of this PE, used by pixmap_gather().
+#endif
+
 // prototypes
 void   colormap_init   (pixel_t *, int);
 void   jitter_init     (double *, double *);
-void   draw_image      (pixmap_t *, pixmap_t *, pixel_t *, int,
-			double, double, double, double *, double *, int, int);
-void   rough_sketch    (pixmap_t *,             pixel_t *, int, double, double, double, int, int);
+void   draw_image      (pixmap_t *, pixmap_t *, long *, pixel_t *, int,
+			double, double, double, double *, double *, int, int, tile_sched_t *);
+void   rough_sketch    (pixmap_t *,             long *, pixel_t *, int, double, double, double, int, int, tile_sched_t *);
 void   pixmap_reduction(pixmap_t *, int, int);
+void   block_range     (int, int, int, int *, int *);
+void   pixmap_gather   (pixmap_t *, bool, int, int, int, int);
+#ifdef USE_MPI
+void   gather_rows     (pixmap_t *, bool, int, int, MPI_Comm);
+#endif
+void   cost_partition  (pixmap_t *, long *, int *, int, int);
+void   halo_range      (int, int, int, int *, int *);
+void   halo_exchange   (void *, size_t, tile_sched_t *, int);
+#ifdef USE_DYNAMIC_DIST
+void   tile_counter_create(tile_counter_t *, int);
+void   tile_counter_free  (tile_counter_t *);
+int    tile_counter_fetch (void *);
+void   tile_counter_reset (void *);
+#endif
+#ifdef USE_OVERLAP_COMM
+void   ship_init       (ship_t *, pixmap_t *, tile_sched_t *, int, int);
+void   ship_fin        (ship_t *, pixmap_t *);
+void   ship_tile       (ship_t *, tile_t *);
+bool   ship_progress   (ship_t *, pixmap_t *);
+#endif
+#ifdef USE_SHARED_WIN
+void   node_init       (node_t *, int);
+void   node_fin        (node_t *);
+void  *node_alloc      (node_t *, size_t);
+void   node_sync       (node_t *);
+#endif
+#ifdef BENCHMARK_TEST
+void   placement_report(const char *, pixmap_t *);
+void   load_report     (double, int, int);
+#endif
 #ifdef VECTOR_LENGTH
 void   mandelbrot      (int, int, int * restrict, real_t * restrict, real_t * restrict);
 #else
@@ -83,32 +195,121 @@ bool_t equivalent_color(pixel_t, pixel_t);
 //======================================================================
 int main(int argc, char **argv)
 {
-    int nprocs = 1, myrank = 0;
+    int nprocs = 1, myrank = 0, status = EXIT_SUCCESS;
+#ifdef USE_BLOCK_DIST
+    int y_head, y_tail;		// row block owned by this PE
+#endif
+    int h_head, h_tail;		// sketch rows held by this PE
+#ifdef REQUIRED_THREAD_LEVEL
+    int provided;
+#endif
+#ifdef USE_DYNAMIC_DIST
+    tile_counter_t counter;
+#endif
     pixmap_t image, sketch;
+    tile_sched_t sched;
+#ifdef USE_SHARED_WIN		// single copies shared among PEs on a node
+    pixel_t *colormap;
+    double  *dx, *dy;
+#else
     pixel_t  colormap[ITER_MAX];
     double   dx[MAX_SAMPLES],
 	     dy[MAX_SAMPLES];
+#endif
+    long    *escape = NULL;	// sum of escape counts in each row of sketch
 #ifdef BENCHMARK_TEST
     double ts, te, tm_init, tm_comp, tm_fin;
 #endif
 
 #ifdef USE_MPI
+#ifdef REQUIRED_THREAD_LEVEL
+    MPI_Init_thread(&argc, &argv, REQUIRED_THREAD_LEVEL, &provided);
+#else
     MPI_Init(&argc, &argv);
+#endif
     MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
 #endif
 
+#ifdef REQUIRED_THREAD_LEVEL
+    if (provided < REQUIRED_THREAD_LEVEL) {
+	if (myrank == 0)
+	    fprintf(stderr, "%s: required thread support of MPI is not available.\n", argv[0]);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+#endif
+
+#ifdef USE_THREAD_BINDING
+    // bind threads before the first touch of pixmap data.
+    if (affinity_bind_threads() != 0 && myrank == 0)
+	fprintf(stderr, "%s: thread binding is not available.\n", argv[0]);
+#endif
+
+#ifdef USE_LB_STAT
+    lb_stat_init(&lb);
+#endif
+
 #ifdef BENCHMARK_TEST
     if (myrank == 0)
 	printf("*** Mandelbrot [%dx%d] #PE=%d ***\n", WIDTH, HEIGHT, nprocs);
     ts      = wtime(true);
 #endif
 
-    // pixmap data allocation, all pixels are zero-cleared.
-    pixmap_create(&image , WIDTH, HEIGHT);
-    pixmap_create(&sketch, WIDTH, HEIGHT);
+    // pixmap data allocation, pages are first-touched by the owner threads.
+#if   defined(USE_SHARED_WIN)	// row blocks of a node are contiguous.
+    node_init(&node, myrank);
+    block_range(HEIGHT, nprocs, node.first + node.rank, &y_head, &y_tail);
+    tile_sched_init_rows(&sched, WIDTH, HEIGHT, y_head, y_tail);
+#elif defined(USE_BLOCK_DIST)
+    block_range(HEIGHT, nprocs, myrank, &y_head, &y_tail);
+#if defined(USE_MPI) && defined(USE_HALO_DIST)
+    if (HEIGHT < nprocs) {	// halo exchange assumes non-empty row blocks.
+	if (myrank == 0)
+	    fprintf(stderr, "%s: too many PEs for the halo exchange.\n", argv[0]);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+#endif
+    tile_sched_init_rows(&sched, WIDTH, HEIGHT, y_head, y_tail);
+#elif defined(USE_DYNAMIC_DIST)
+    tile_sched_init(&sched, WIDTH, HEIGHT, 1, 0);	// all tiles, dealt to PEs on demand
+    tile_counter_create(&counter, myrank);
+    tile_sched_set_source(&sched, tile_counter_fetch, tile_counter_reset, &counter);
+#else
+    tile_sched_init(&sched, WIDTH, HEIGHT, nprocs, myrank);
+#endif
+    halo_range(HEIGHT, sched.y_head, sched.y_tail, &h_head, &h_tail);
+#ifdef USE_SHARED_WIN		// pixmaps on shared windows, released by node_fin().
+    image .width  = sketch.width  = WIDTH ;
+    image .height = sketch.height = HEIGHT;
+    image .data   = (pixel_t *) node_alloc(&node, (size_t) WIDTH * HEIGHT * sizeof(pixel_t));
+    sketch.data   = (pixel_t *) node_alloc(&node, (size_t) WIDTH * HEIGHT * sizeof(pixel_t));
+#else
+    pixmap_allocate(&image , WIDTH, HEIGHT);
+    pixmap_allocate(&sketch, WIDTH, h_tail - h_head);
+#endif
+    tile_sched_first_touch(&sched, image .data, sizeof(pixel_t));
+#ifndef USE_HALO_DIST		// otherwise, first-touched by rough_sketch().
+    tile_sched_first_touch(&sched, sketch.data, sizeof(pixel_t));
+#endif
+#ifdef USE_WEIGHTED_DIST
+    if ((escape = (long *) malloc(HEIGHT * sizeof(long))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+#endif
+#ifdef USE_SHARED_WIN
+    colormap = (pixel_t *) node_alloc(&node, ITER_MAX    * sizeof(pixel_t));
+    dx       = (double  *) node_alloc(&node, MAX_SAMPLES * sizeof(double ));
+    dy       = (double  *) node_alloc(&node, MAX_SAMPLES * sizeof(double ));
+    if (node.rank == 0) {
+	colormap_init(colormap, ITER_MAX);
+	jitter_init(dx, dy);
+    }
+    node_sync(&node);
+#else
     colormap_init(colormap, ITER_MAX);
     jitter_init(dx, dy);
+#endif
 
 #ifdef BENCHMARK_TEST
     te      = wtime(true);
@@ -116,21 +317,44 @@ int main(int argc, char **argv)
     ts      = te;
 #endif
 
-    draw_image(&image, &sketch, colormap,
-		ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy, nprocs, myrank);
+    draw_image(&image, &sketch, escape, colormap,
+		ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy, nprocs, myrank, &sched);
 
 #ifdef BENCHMARK_TEST
     te      = wtime(true);
     tm_comp = te - ts;
-    ts      = te;
+    if (myrank == 0) {
+	placement_report("image ", &image );
+	placement_report("sketch", &sketch);
+    }
+    ts      = wtime(true);
 #endif
 
+#ifdef USE_MPIIO_OUTPUT		// each PE writes its own row block.
+    status = ppm_io_write_rows("output.ppm", WIDTH, HEIGHT, sched.y_head, sched.y_tail,
+			       image.data + (size_t) sched.y_head * WIDTH);
+    if (status != EXIT_SUCCESS && myrank == 0)	// the status is the same on all PEs.
+	fprintf(stderr, "%s: cannot write output.ppm.\n", argv[0]);
+#else
     if (myrank == 0)
 	pixmap_write_ppmfile(&image, "output.ppm");
+#endif
 
     // pixmap data deallocation
+    free(escape);
+#ifdef USE_SHARED_WIN
+    node_fin(&node);
+#else
     pixmap_destroy(&sketch);
     pixmap_destroy(&image );
+#endif
+    tile_sched_fin(&sched);
+#ifdef USE_DYNAMIC_DIST
+    tile_counter_free(&counter);
+#endif
+#ifdef USE_LB_STAT
+    lb_stat_fin(&lb);
+#endif
 
 #ifdef BENCHMARK_TEST
     te      = wtime(true);
@@ -144,7 +368,7 @@ int main(int argc, char **argv)
     MPI_Finalize();
 #endif
 
-    return EXIT_SUCCESS;
+    return status;
 }
 
 //----------------------------------------------------------------------
@@ -205,78 +429,123 @@ void jitter_init(double *dx, double *dy)
 #endif
 
 //----------------------------------------------------------------------
-void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap, int iter_max,
-	double c_r, double c_i, double radius, double *dx, double *dy, int nprocs, int myrank)
+void draw_image(pixmap_t *image, pixmap_t *sketch, long *escape, pixel_t *colormap, int iter_max,
+	double c_r, double c_i, double radius, double *dx, double *dy, int nprocs, int myrank, tile_sched_t *sched)
 {				// adaptive anti-aliasing
     int iter_mask = iter_max - 1;
-    int width, height;
+    int width, height, h_head, h_tail;
     double d;
+#ifdef USE_OVERLAP_COMM
+    ship_t ship;
+#endif
 #ifdef BENCHMARK_TEST
-    double ts, te;
+    double ts, tb, te;
 #endif
 
-    rough_sketch(sketch, colormap, iter_max, c_r, c_i, radius, nprocs, myrank);
+    rough_sketch(sketch, escape, colormap, iter_max, c_r, c_i, radius, nprocs, myrank, sched);
+
+#ifdef USE_WEIGHTED_DIST
+    {				// re-partition rows for refinement by estimated cost.
+	int y_part[nprocs + 1];
+	cost_partition(sketch, escape, y_part, nprocs, myrank);
+	tile_sched_fin      (sched);
+	tile_sched_init_rows(sched, sched->width, sched->height,
+				y_part[myrank], y_part[myrank + 1]);
+    }
+#endif
 
 #ifdef BENCHMARK_TEST
     ts = wtime(true);
 #endif
 
     pixmap_get_size(image, &width, &height);
+    halo_range(height, sched->y_head, sched->y_tail, &h_head, &h_tail);
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = myrank; xy < width * height; xy += nprocs) {
-	int x = xy % width,
-	    y = xy / width;
-	pixel_t pixel;
-	if (detect_edge(sketch, &pixel, x, y)) {
-	    pixel_t average  = pixel;
-	    int m     = 1, n = MIN_SAMPLES,
-		sum_r = pixel_get_r(pixel),
-		sum_g = pixel_get_g(pixel),
-		sum_b = pixel_get_b(pixel);
-	    do {
-		pixel = average;
+#ifdef USE_OVERLAP_COMM
+    ship_init(&ship, image, sched, nprocs, myrank);
+#endif
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	LB_MARK();
+#if defined(_OPENMP) && defined(USE_PROGRESS_THREAD)
+	if (omp_get_thread_num() == 0 && omp_get_num_threads() > 1)
+	    while (ship_progress(&ship, image))	// dedicated to MPI progress
+		;
+	else
+#endif
+	while (tile_sched_next(sched, &tile)) {
+	    LB_LAP(LB_COMM);
+	    for (int y = tile.y; y < tile.y + tile.height; y++)
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    pixel_t pixel;
+		    if (detect_edge(sketch, &pixel, x, y - h_head)) {
+			pixel_t average  = pixel;
+			int m     = 1, n = MIN_SAMPLES,
+			    sum_r = pixel_get_r(pixel),
+			    sum_g = pixel_get_g(pixel),
+			    sum_b = pixel_get_b(pixel);
+			do {
+			    pixel = average;
 #ifdef VECTOR_LENGTH
-		for (int k = m; k < n; k += VECTOR_LENGTH) {	// pixel refinement with QMC/MC integration
-		    int   vlen = MIN(VECTOR_LENGTH, n - k);
-		    int   iter[VECTOR_LENGTH];
-		    real_t p_r[VECTOR_LENGTH], p_i[VECTOR_LENGTH];
-		    for (int j = 0; j < vlen; j++) {
-			p_r[j] = c_r + d * ((x + dx[k + j]) - width  / 2);
-			p_i[j] = c_i + d * (height / 2 - (y + dy[k + j]));
-		    }
-		    mandelbrot(vlen, iter_max, iter, p_r, p_i);
-		    for (int j = 0; j < vlen; j++) {
-			sum_r += pixel_get_r(colormap[iter[j] & iter_mask]);
-			sum_g += pixel_get_g(colormap[iter[j] & iter_mask]);
-			sum_b += pixel_get_b(colormap[iter[j] & iter_mask]);
-		    }
-		}
+			    for (int k = m; k < n; k += VECTOR_LENGTH) {	// pixel refinement with QMC/MC integration
+				int   vlen = MIN(VECTOR_LENGTH, n - k);
+				int   iter[VECTOR_LENGTH];
+				real_t p_r[VECTOR_LENGTH], p_i[VECTOR_LENGTH];
+				for (int j = 0; j < vlen; j++) {
+				    p_r[j] = c_r + d * ((x + dx[k + j]) - width  / 2);
+				    p_i[j] = c_i + d * (height / 2 - (y + dy[k + j]));
+				}
+				mandelbrot(vlen, iter_max, iter, p_r, p_i);
+				for (int j = 0; j < vlen; j++) {
+				    sum_r += pixel_get_r(colormap[iter[j] & iter_mask]);
+				    sum_g += pixel_get_g(colormap[iter[j] & iter_mask]);
+				    sum_b += pixel_get_b(colormap[iter[j] & iter_mask]);
+				}
+			    }
 #else				//......................................
 #ifdef USE_OMP_SIMD
 #pragma omp simd reduction(+:sum_r,sum_g,sum_b)
 #endif
-		for (int k = m; k < n; k++) {	// pixel refinement with QMC/MC integration
-		    double p_r = c_r + d * ((x + dx[k]) - width  / 2),
-			   p_i = c_i + d * (height / 2 - (y + dy[k]));
-		    int   iter = mandelbrot(iter_max, p_r, p_i);
-		    sum_r += pixel_get_r(colormap[iter & iter_mask]);
-		    sum_g += pixel_get_g(colormap[iter & iter_mask]);
-		    sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			    for (int k = m; k < n; k++) {	// pixel refinement with QMC/MC integration
+				double p_r = c_r + d * ((x + dx[k]) - width  / 2),
+				       p_i = c_i + d * (height / 2 - (y + dy[k]));
+				int   iter = mandelbrot(iter_max, p_r, p_i);
+				sum_r += pixel_get_r(colormap[iter & iter_mask]);
+				sum_g += pixel_get_g(colormap[iter & iter_mask]);
+				sum_b += pixel_get_b(colormap[iter & iter_mask]);
+			    }
+#endif
+			    average = pixel_set_rgb(ROUND((double) sum_r / n),
+						    ROUND((double) sum_g / n),
+						    ROUND((double) sum_b / n));
+			} while (!equivalent_color(average, pixel) &&
+				    (n = (m = n) << 0x01) <= MAX_SAMPLES);
+			pixel = average;
+		    }
+		    pixmap_put_pixel(image, pixel, x, y);
 		}
+	    LB_TILE(&tile);
+#ifdef USE_OVERLAP_COMM
+	    ship_tile(&ship, &tile);
+#pragma omp master		// unless dedicated to MPI progress
+	    ship_progress(&ship, image);
 #endif
-		average = pixel_set_rgb(ROUND((double) sum_r / n),
-					ROUND((double) sum_g / n),
-					ROUND((double) sum_b / n));
-	    } while (!equivalent_color(average, pixel) &&
-			(n = (m = n) << 0x01) <= MAX_SAMPLES);
-	    pixel = average;
 	}
-	pixmap_put_pixel(image, pixel, x, y);
+	LB_LAP(LB_COMM);
+	LB_BARRIER();
     }
 
+#ifdef BENCHMARK_TEST
+    tb = wtime(false);		// busy time of this PE, before waiting for others
+#endif
+
+    LB_SYNC();			// before the barrier below, to charge waiting for others
 #ifdef BENCHMARK_TEST
     te = wtime(true);
     if (myrank == 0)
@@ -287,18 +556,34 @@ void draw_image(pixmap_t *image, pixmap_t *sketch, pixel_t *colormap, int iter_m
 #endif
 #endif
 
+#if   defined(USE_OVERLAP_COMM)
+    ship_fin(&ship, image);
+#elif defined(USE_MPIIO_OUTPUT)	// no gather, row blocks are written by their owners.
+#elif defined(USE_BLOCK_DIST)
+    pixmap_gather(image , false, sched->y_head, sched->y_tail, nprocs, myrank);
+#else
     pixmap_reduction(image, nprocs, myrank);
+#endif
+    LB_LAP(LB_COMM);
+
+#ifdef BENCHMARK_TEST
+    load_report(tb - ts, nprocs, myrank);
+#endif
+
+#ifdef USE_LB_STAT
+    lb_stat_report(&lb, LB_STAT_CSV);
+#endif
 
     return;
 }
 
 //----------------------------------------------------------------------
-void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
-		double c_r, double c_i, double radius, int nprocs, int myrank)
+void rough_sketch(pixmap_t *sketch, long *escape, pixel_t *colormap, int iter_max,
+		double c_r, double c_i, double radius, int nprocs, int myrank, tile_sched_t *sched)
 #ifdef VECTOR_LENGTH
 {				// rough sketch image
     int iter_mask = iter_max - 1;
-    int width, height;
+    int width, height, h_head, h_tail;
     double d;
 #ifdef BENCHMARK_TEST
     double ts, te;
@@ -306,30 +591,51 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
     ts = wtime(true);
 #endif
 
-    pixmap_get_size(sketch, &width, &height);
+    width  = sched->width ;	// sketch may hold only a part of rows.
+    height = sched->height;
+    halo_range(height, sched->y_head, sched->y_tail, &h_head, &h_tail);
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy  = myrank * VECTOR_LENGTH; width * height > xy ;
-	     xy += nprocs * VECTOR_LENGTH) {
-	int   vlen = MIN(VECTOR_LENGTH, width * height - xy);
-	int   iter[VECTOR_LENGTH];
-	real_t p_r[VECTOR_LENGTH], p_i[VECTOR_LENGTH];
-	for (int j = 0; j < vlen; j++) {
-	    int x = (j + xy) % width,
-		y = (j + xy) / width;
-	    p_r[j] = c_r + d * (x - width  / 2);
-	    p_i[j] = c_i + d * (height / 2 - y);
-	}
-	mandelbrot(vlen, iter_max, iter, p_r, p_i);
-	for (int j = 0; j < vlen; j++) {
-	    int x = (j + xy) % width,
-		y = (j + xy) / width;
-	    pixmap_put_pixel(sketch, colormap[iter[j] & iter_mask], x, y);
+    if (escape != NULL)
+	memset(escape, 0x00, height * sizeof(long));
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	LB_MARK();
+	while (tile_sched_next(sched, &tile)) {
+	    LB_LAP(LB_COMM);
+	    for (int y = tile.y; y < tile.y + tile.height; y++) {
+		long sum = 0;
+		for (int x = tile.x; x < tile.x + tile.width; x += VECTOR_LENGTH) {
+		    int   vlen = MIN(VECTOR_LENGTH, tile.x + tile.width - x);
+		    int   iter[VECTOR_LENGTH];
+		    real_t p_r[VECTOR_LENGTH], p_i[VECTOR_LENGTH];
+		    for (int j = 0; j < vlen; j++) {
+			p_r[j] = c_r + d * (x + j - width  / 2);
+			p_i[j] = c_i + d * (height / 2 - y);
+		    }
+		    mandelbrot(vlen, iter_max, iter, p_r, p_i);
+		    for (int j = 0; j < vlen; j++) {
+			pixmap_put_pixel(sketch, colormap[iter[j] & iter_mask], x + j, y - h_head);
+			sum += iter[j];
+		    }
+		}
+		if (escape != NULL) {
+#pragma omp atomic
+		    escape[y] += sum;
+		}
+	    }
+	    LB_TILE(&tile);
 	}
+	LB_LAP(LB_COMM);
+	LB_BARRIER();
     }
 
+    LB_SYNC();
 #ifdef BENCHMARK_TEST
     te = wtime(true);
     if (myrank == 0)
@@ -340,14 +646,21 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
 #endif
 #endif
 
+#if   defined(USE_HALO_DIST)
+    halo_exchange(sketch->data, width * SIZEOF_PIXEL_T, sched, myrank);
+#elif defined(USE_BLOCK_DIST)
+    pixmap_gather(sketch, true , sched->y_head, sched->y_tail, nprocs, myrank);
+#else
     pixmap_reduction(sketch, nprocs, myrank);
+#endif
+    LB_LAP(LB_COMM);
 
     return;
 }
 #else				//......................................
 {				// rough sketch image
     int iter_mask = iter_max - 1;
-    int width, height;
+    int width, height, h_head, h_tail;
     double d;
 #ifdef BENCHMARK_TEST
     double ts, te;
@@ -355,20 +668,44 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
     ts = wtime(true);
 #endif
 
-    pixmap_get_size(sketch, &width, &height);
+    width  = sched->width ;	// sketch may hold only a part of rows.
+    height = sched->height;
+    halo_range(height, sched->y_head, sched->y_tail, &h_head, &h_tail);
 
     d = 2.0 * radius / MIN(width, height);
 
-#pragma omp parallel for schedule(static,1)
-    for (int xy = myrank; xy < width * height; xy += nprocs) {
-	int    x   = xy % width,
-	       y   = xy / width;
-	double p_r = c_r + d * (x - width  / 2),
-	       p_i = c_i + d * (height / 2 - y);
-	int   iter = mandelbrot(iter_max, p_r, p_i);
-	pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y);
+    if (escape != NULL)
+	memset(escape, 0x00, height * sizeof(long));
+
+    tile_sched_reset(sched);
+
+#pragma omp parallel
+    {
+	tile_t tile;
+	LB_MARK();
+	while (tile_sched_next(sched, &tile)) {
+	    LB_LAP(LB_COMM);
+	    for (int y = tile.y; y < tile.y + tile.height; y++) {
+		long sum = 0;
+		for (int x = tile.x; x < tile.x + tile.width; x++) {
+		    double p_r = c_r + d * (x - width  / 2),
+			   p_i = c_i + d * (height / 2 - y);
+		    int   iter = mandelbrot(iter_max, p_r, p_i);
+		    pixmap_put_pixel(sketch, colormap[iter & iter_mask], x, y - h_head);
+		    sum += iter;
+		}
+		if (escape != NULL) {
+#pragma omp atomic
+		    escape[y] += sum;
+		}
+	    }
+	    LB_TILE(&tile);
+	}
+	LB_LAP(LB_COMM);
+	LB_BARRIER();
     }
 
+    LB_SYNC();
 #ifdef BENCHMARK_TEST
     te = wtime(true);
     if (myrank == 0)
@@ -379,12 +716,279 @@ void rough_sketch(pixmap_t *sketch, pixel_t *colormap, int iter_max,
 #endif
 #endif
 
+#if   defined(USE_HALO_DIST)
+    halo_exchange(sketch->data, width * SIZEOF_PIXEL_T, sched, myrank);
+#elif defined(USE_BLOCK_DIST)
+    pixmap_gather(sketch, true , sched->y_head, sched->y_tail, nprocs, myrank);
+#else
     pixmap_reduction(sketch, nprocs, myrank);
+#endif
+    LB_LAP(LB_COMM);
 
     return;
 }
 #endif
 
+#ifdef BENCHMARK_TEST
+//----------------------------------------------------------------------
+void placement_report(const char *name, pixmap_t *pixmap)
+{				// report # of pages of pixmap data on each NUMA node.
+    long npages[AFFINITY_MAX_NODES];
+    int  width, height, nnodes;
+
+    pixmap_get_size(pixmap, &width, &height);
+
+    nnodes = affinity_query_nodes(pixmap->data,
+		(size_t) width * height * sizeof(pixel_t), npages);
+
+    printf("Placement(%s)=", name);
+    if (nnodes < 0)
+	printf("unknown\n");
+    else {
+	for (int i = 0; i < nnodes; i++)
+	    printf("%snode%d:%ld", (i == 0) ? "" : ",", i, npages[i]);
+	printf("[pages]\n");
+    }
+
+    return;
+}
+
+
+//----------------------------------------------------------------------
+void load_report(double busy, int nprocs, int myrank)
+#ifdef USE_MPI
+{				// report busy/idle time of PEs in rendering,
+				// idle time is spent waiting for the slowest PE.
+    double *t_busy = NULL, t_max = 0.0, t_sum = 0.0;
+
+    if (myrank == 0 &&
+	(t_busy = (double *) malloc(nprocs * sizeof(double))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Gather(&busy, 1, MPI_DOUBLE, t_busy, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (myrank == 0) {
+	for (int p = 0; p < nprocs; p++) {
+	    t_max  = MAX(t_max, t_busy[p]);
+	    t_sum +=            t_busy[p];
+	}
+	for (int p = 0; p < nprocs; p++)
+	    printf("PE%-4d: busy=%10.3f[sec.], idle=%10.3f[sec.]\n",
+					p, t_busy[p], t_max - t_busy[p]);
+	printf("Imbalance=%.3f (max/avg)\n", t_max * nprocs / t_sum);
+	free(t_busy);
+    }
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+#endif
+
+#ifdef USE_DYNAMIC_DIST
+//----------------------------------------------------------------------
+void tile_counter_create(tile_counter_t *counter, int myrank)
+{				// collective: a tile counter is allocated on PE0.
+    MPI_Win_allocate((myrank == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL,
+		     MPI_COMM_WORLD, &counter->count, &counter->win);
+
+    if (myrank == 0)
+	*counter->count = 0;
+    counter->myrank = myrank;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, counter->win);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_counter_free(tile_counter_t *counter)
+{				// collective
+    MPI_Win_unlock_all(counter->win);
+    MPI_Win_free(&counter->win);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+int tile_counter_fetch(void *arg)
+{				// take next tile index by an atomic fetch-and-add on PE0.
+    tile_counter_t *counter = (tile_counter_t *) arg;
+    const int one = 1;
+    int k;
+
+#pragma omp critical (tile_counter)
+    {
+	MPI_Fetch_and_op(&one, &k, MPI_INT, 0, 0, MPI_SUM, counter->win);
+	MPI_Win_flush(0, counter->win);
+    }
+
+    return k;
+}
+
+//----------------------------------------------------------------------
+void tile_counter_reset(void *arg)
+{				// collective: rewind the counter between stages.
+				// all PEs have finished fetching of the previous stage.
+    tile_counter_t *counter = (tile_counter_t *) arg;
+    const int zero = 0;
+    int k;
+
+    if (counter->myrank == 0) {
+	MPI_Fetch_and_op(&zero, &k, MPI_INT, 0, 0, MPI_REPLACE, counter->win);
+	MPI_Win_flush(0, counter->win);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    return;
+}
+#endif
+
+#ifdef USE_OVERLAP_COMM
+//----------------------------------------------------------------------
+void ship_init(ship_t *ship, pixmap_t *image, tile_sched_t *sched, int nprocs, int myrank)
+{				// collective: PE0 posts receives of all bands of other PEs
+				// in place, sends are posted as bands are rendered.
+    int width, height, range[2] = { sched->y_head, sched->y_tail }, *rows;
+
+    pixmap_get_size(image, &width, &height);
+
+    ship->y_head     = sched->y_head;
+    ship->y_tail     = sched->y_tail;
+    ship->num_bands  = (ship->y_tail - ship->y_head + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    ship->num_posted = 0;
+    ship->num_reqs   = 0;
+    ship->num_done   = 0;
+    ship->myrank     = myrank;
+
+    if ((rows = (int *) malloc(2 * nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // row blocks of all PEs
+    MPI_Allgather(range, 2, MPI_INT, rows, 2, MPI_INT, MPI_COMM_WORLD);
+
+    if (myrank == 0)
+	for (int p = 1; p < nprocs; p++)
+	    ship->num_reqs += (rows[2 * p + 1] - rows[2 * p] + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    else
+	ship->num_reqs  = ship->num_bands;
+
+    // a PE may have no bands, and PE0 has no receives if nprocs == 1.
+    if ((ship->remain = (int         *) malloc(MAX(1, ship->num_bands) * sizeof(int        ))) == NULL ||
+	(ship->posted = (bool        *) malloc(MAX(1, ship->num_bands) * sizeof(bool       ))) == NULL ||
+	(ship->index  = (int         *) malloc(MAX(1, ship->num_reqs ) * sizeof(int        ))) == NULL ||
+	(ship->req    = (MPI_Request *) malloc(MAX(1, ship->num_reqs ) * sizeof(MPI_Request))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int b = 0; b < ship->num_bands; b++) {
+	ship->remain[b] = sched->num_tiles_x;
+	ship->posted[b] = false;
+    }
+
+    if (myrank == 0)		// bands of PE p are tagged with their indices in the block.
+	for (int p = 1, k = 0; p < nprocs; p++)
+	    for (int y = rows[2 * p]; y < rows[2 * p + 1]; y += TILE_HEIGHT)
+		MPI_Irecv(image->data + (size_t) y * width,
+			  MIN(TILE_HEIGHT, rows[2 * p + 1] - y) * width * SIZEOF_PIXEL_T, MPI_BYTE,
+			  p, (y - rows[2 * p]) / TILE_HEIGHT, MPI_COMM_WORLD, &ship->req[k++]);
+
+    free(rows);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void ship_fin(ship_t *ship, pixmap_t *image)
+{				// collective: ship the rest of bands, and wait for completion.
+    int num_early = ship->num_done;
+#ifdef BENCHMARK_TEST
+    double ts, te;
+
+    ts = wtime(true);
+#endif
+
+    ship_progress(ship, image);
+    MPI_Waitall(ship->num_reqs, ship->req, MPI_STATUSES_IGNORE);
+
+#ifdef BENCHMARK_TEST
+    te = wtime(true);
+    if (ship->myrank == 0) {	// communication hidden behind rendering
+	printf("Reduction=%.3f[sec.]\n", te - ts);
+	printf("Overlap  =%5.1f%% (%d/%d bands received in rendering)\n",
+		100.0 * num_early / MAX(1, ship->num_reqs), num_early, ship->num_reqs);
+    }
+#else
+    (void) num_early;
+#endif
+
+    free(ship->req   );
+    free(ship->index );
+    free(ship->posted);
+    free(ship->remain);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void ship_tile(ship_t *ship, tile_t *tile)
+{				// a tile has been rendered (by any thread).
+    int b = (tile->y - ship->y_head) / TILE_HEIGHT;
+
+    // seq_cst implies a flush, pixels of the tile are visible to the master thread.
+#pragma omp atomic update seq_cst
+    ship->remain[b]--;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+bool ship_progress(ship_t *ship, pixmap_t *image)
+{				// master thread only (MPI_THREAD_FUNNELED): post sends of rendered
+				// bands, and drive pending requests.
+				// return true while some bands are left to be rendered.
+    int width = image->width, active, count;
+
+    for (int b = 0; b < ship->num_bands; b++)
+	if (!ship->posted[b]) {
+	    int remain;
+#pragma omp atomic read seq_cst
+	    remain = ship->remain[b];
+	    if (remain == 0) {
+		if (ship->myrank != 0) {
+		    int y = ship->y_head + b * TILE_HEIGHT;
+		    MPI_Isend(image->data + (size_t) y * width,
+			      MIN(TILE_HEIGHT, ship->y_tail - y) * width * SIZEOF_PIXEL_T, MPI_BYTE,
+			      0, b, MPI_COMM_WORLD, &ship->req[ship->num_posted]);
+		}
+		ship->posted[b] = true;
+		ship->num_posted++;
+	    }
+	}
+
+    // receives on PE0 are all posted in advance.
+    active = (ship->myrank == 0) ? ship->num_reqs : ship->num_posted;
+
+    if (active > 0) {
+	MPI_Testsome(active, ship->req, &count, ship->index, MPI_STATUSES_IGNORE);
+	if (count != MPI_UNDEFINED)
+	    ship->num_done += count;
+    }
+
+    return ship->num_posted < ship->num_bands;
+}
+#endif
+
 //----------------------------------------------------------------------
 void pixmap_reduction(pixmap_t *pixmap, int nprocs, int myrank)
 #ifdef USE_MPI
@@ -396,7 +1000,7 @@ void pixmap_reduction(pixmap_t *pixmap, int nprocs, int myrank)
     ts = wtime(true);
 #endif
 
-    pixmap_get_size(pixmap, &width, height);
+    pixmap_get_size(pixmap, &width, &height);
 
     MPI_Allreduce(MPI_IN_PLACE, pixmap->data, width * height * SIZEOF_PIXEL_T,
 		  MPI_BYTE, MPI_BOR, MPI_COMM_WORLD);
@@ -415,6 +1019,313 @@ void pixmap_reduction(pixmap_t *pixmap, int nprocs, int myrank)
 }
 #endif
 
+//----------------------------------------------------------------------
+void block_range(int height, int nprocs, int rank, int *y_head, int *y_tail)
+{				// row block [y_head:y_tail) owned by a PE.
+    *y_head = (long) height *  rank      / nprocs;
+    *y_tail = (long) height * (rank + 1) / nprocs;
+
+    return;
+}
+
+#ifdef USE_SHARED_WIN
+//----------------------------------------------------------------------
+void node_init(node_t *node, int myrank)
+{				// collective: group PEs by shared-memory node.
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myrank, MPI_INFO_NULL, &node->comm);
+    MPI_Comm_rank(node->comm, &node->rank);
+    MPI_Comm_size(node->comm, &node->size);
+
+    // PE0 of COMM_WORLD is the leader of the 1st node.
+    MPI_Comm_split(MPI_COMM_WORLD, (node->rank == 0) ? 0 : MPI_UNDEFINED, myrank, &node->leader);
+
+    node->first    = 0;
+    node->num_wins = 0;
+
+    if (node->leader != MPI_COMM_NULL) {
+	int rank, first;
+	MPI_Comm_rank(node->leader, &rank);
+	MPI_Exscan(&node->size, &first, 1, MPI_INT, MPI_SUM, node->leader);
+	if (rank > 0)		// undefined on the 1st leader
+	    node->first = first;
+    }
+
+    MPI_Bcast(&node->first, 1, MPI_INT, 0, node->comm);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void node_fin(node_t *node)
+{				// collective: release shared windows and communicators.
+    for (int i = 0; i < node->num_wins; i++) {
+	MPI_Win_unlock_all(node->win[i]);
+	MPI_Win_free(&node->win[i]);
+    }
+
+    if (node->leader != MPI_COMM_NULL)
+	MPI_Comm_free(&node->leader);
+    MPI_Comm_free(&node->comm);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void *node_alloc(node_t *node, size_t size)
+{				// collective: allocate a single copy of data on the node leader,
+				// mapped by all PEs of the node.
+    MPI_Aint win_size;
+    int      disp_unit;
+    void    *base;
+
+    if (node->num_wins >= NODE_MAX_WINS) {
+	fprintf(stderr, "%s: too many shared windows.\n", __func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Win_allocate_shared((node->rank == 0) ? size : 0, 1, MPI_INFO_NULL,
+			    node->comm, &base, &node->win[node->num_wins]);
+    MPI_Win_shared_query(node->win[node->num_wins], 0, &win_size, &disp_unit, &base);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, node->win[node->num_wins++]);
+
+    return base;
+}
+
+//----------------------------------------------------------------------
+void node_sync(node_t *node)
+{				// collective: make stores to shared windows visible in the node.
+    for (int i = 0; i < node->num_wins; i++)
+	MPI_Win_sync(node->win[i]);
+
+    MPI_Barrier(node->comm);
+
+    for (int i = 0; i < node->num_wins; i++)
+	MPI_Win_sync(node->win[i]);
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void cost_partition(pixmap_t *sketch, long *escape, int *y_part, int nprocs, int myrank)
+{				// partition rows into contiguous ranges [y_part[p]:y_part[p+1])
+				// of equal refinement cost estimated from the whole sketch:
+				// # of edge pixels weighted by the mean escape count of
+				// neighbourhood rows.
+    int width, height, p = 1;
+    double *cost, total = 0.0, prefix = 0.0;
+
+    pixmap_get_size(sketch, &width, &height);
+
+    if ((cost = (double *) malloc(height * sizeof(double))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, escape, height, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+#pragma omp parallel for schedule(dynamic)
+    for (int y = 0; y < height; y++) {
+	long edges = 0, sum = 0, rows = 0;
+	for (int x = 0; x < width; x++) {
+	    pixel_t pixel;
+	    if (detect_edge(sketch, &pixel, x, y))
+		edges++;
+	}
+	for (int j = MAX(0, y - 1); j <= MIN(height - 1, y + 1); j++, rows++)
+	    sum += escape[j];
+	cost[y] = 1.0 + (double) edges * sum / (rows * width);
+    }
+
+    for (int y = 0; y < height; y++)
+	total += cost[y];
+
+    y_part[0] = 0;
+    for (int y = 0; y < height && p < nprocs; y++) {
+	// cut before row y if the target is in its former half.
+	while (p < nprocs && total * p / nprocs <= prefix + 0.5 * cost[y])
+	    y_part[p++] = y;
+	prefix += cost[y];
+    }
+    while (p < nprocs)		// cuts left open after the last row
+	y_part[p++] = height;
+    y_part[nprocs] = height;
+
+#ifdef DEBUG
+    for (p = 0; p < nprocs; p++)
+	if (y_part[p] > y_part[p + 1]) {
+	    fprintf(stderr, "%s: cuts are not monotonic at #%d.\n", __func__, p);
+	    exit(EXIT_FAILURE);
+	}
+#endif
+
+#ifdef BENCHMARK_TEST
+    if (myrank == 0) {		// estimated imbalance (max/avg) of equal-rows and weighted partitions
+	double max_block = 0.0, max_part = 0.0;
+	for (int p = 0; p < nprocs; p++) {
+	    int    y_head, y_tail;
+	    double c_block = 0.0, c_part = 0.0;
+	    block_range(height, nprocs, p, &y_head, &y_tail);
+	    for (int y = y_head   ; y < y_tail       ; y++)
+		c_block += cost[y];
+	    for (int y = y_part[p]; y < y_part[p + 1]; y++)
+		c_part  += cost[y];
+	    max_block = MAX(max_block, c_block);
+	    max_part  = MAX(max_part , c_part );
+	}
+	printf("Imbalance(estimated)=%.3f(block) -> %.3f(weighted)\n",
+		max_block * nprocs / total, max_part * nprocs / total);
+    }
+#endif
+
+    free(cost);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void pixmap_gather(pixmap_t *pixmap, bool all, int y_head, int y_tail, int nprocs, int myrank)
+#ifdef USE_MPI
+{				// gather row blocks [y_head:y_tail) of pixmap image to PE0 (or all PEs).
+#ifdef BENCHMARK_TEST
+    double ts, te;
+
+    ts = wtime(true);
+#endif
+
+#ifdef USE_SHARED_WIN		// node leaders gather row blocks of their nodes.
+    node_sync(&node);
+    if (node.leader != MPI_COMM_NULL) {
+	int width, height, tail, head;
+	pixmap_get_size(pixmap, &width, &height);
+	// rows of the node: row blocks of its PEs in node-major order
+	block_range(height, nprocs, node.first                , &y_head, &tail  );
+	block_range(height, nprocs, node.first + node.size - 1, &head  , &y_tail);
+	gather_rows(pixmap, all, y_head, y_tail, node.leader);
+    }
+    if (all)			// PEs on the node wait for the leader.
+	node_sync(&node);
+#else
+    gather_rows(pixmap, all, y_head, y_tail, MPI_COMM_WORLD);
+#endif
+
+#ifdef BENCHMARK_TEST
+    te = wtime(true);
+    if (myrank == 0)
+	printf("Reduction=%.3f[sec.]\n", te - ts);
+#endif
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+
+#ifdef USE_MPI
+//----------------------------------------------------------------------
+void gather_rows(pixmap_t *pixmap, bool all, int y_head, int y_tail, MPI_Comm comm)
+{				// gather row blocks [y_head:y_tail) of PEs in comm. to rank 0 (or all).
+    int width, height, nprocs, myrank,
+	range[2] = { y_head, y_tail }, *rows = NULL, *count = NULL, *displ = NULL;
+
+    pixmap_get_size(pixmap, &width, &height);
+
+    MPI_Comm_size(comm, &nprocs);
+    MPI_Comm_rank(comm, &myrank);
+
+    if ((rows  = (int *) malloc(2 * nprocs * sizeof(int))) == NULL ||
+	(count = (int *) malloc(    nprocs * sizeof(int))) == NULL ||
+	(displ = (int *) malloc(    nprocs * sizeof(int))) == NULL) {
+	perror(__func__);
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // row blocks of all PEs
+    MPI_Allgather(range, 2, MPI_INT, rows, 2, MPI_INT, comm);
+
+    for (int p = 0; p < nprocs; p++) {
+	count[p] = (rows[2 * p + 1] - rows[2 * p]) * width * SIZEOF_PIXEL_T;
+	displ[p] =  rows[2 * p]                    * width * SIZEOF_PIXEL_T;
+    }
+
+    if (all)
+	MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		       pixmap->data, count, displ, MPI_BYTE, comm);
+    else
+	MPI_Gatherv((myrank == 0) ? MPI_IN_PLACE : (char *) pixmap->data + displ[myrank],
+		    count[myrank], MPI_BYTE,
+		    pixmap->data, count, displ, MPI_BYTE, 0, comm);
+
+    free(displ);
+    free(count);
+    free(rows );
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void halo_range(int height, int y_head, int y_tail, int *h_head, int *h_tail)
+#ifdef USE_HALO_DIST
+{				// sketch rows [h_head:h_tail) held by a PE: own row block and one-row halo.
+    *h_head = MAX(0     , y_head - 1);
+    *h_tail = MIN(height, y_tail + 1);
+
+    return;
+}
+#else				//......................................
+{				// sketch holds all rows.
+    *h_head = 0;
+    *h_tail = height;
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+void halo_exchange(void *data, size_t row_size, tile_sched_t *sched, int myrank)
+#ifdef USE_MPI
+{				// exchange one-row halo of sketch data with neighbour PEs.
+    int h_head, h_tail, upper, lower;
+    char *rows = (char *) data;
+#ifdef BENCHMARK_TEST
+    double ts, te;
+
+    ts = wtime(true);
+#endif
+
+    halo_range(sched->height, sched->y_head, sched->y_tail, &h_head, &h_tail);
+
+    upper = (h_head < sched->y_head) ? myrank - 1 : MPI_PROC_NULL;
+    lower = (h_tail > sched->y_tail) ? myrank + 1 : MPI_PROC_NULL;
+
+    // 1st own row to the upper PE, lower halo from the lower PE.
+    MPI_Sendrecv(rows + (size_t) (sched->y_head     - h_head) * row_size, row_size, MPI_BYTE, upper, 0,
+		 rows + (size_t) (h_tail            - h_head - 1) * row_size, row_size, MPI_BYTE, lower, 0,
+		 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    // last own row to the lower PE, upper halo from the upper PE.
+    MPI_Sendrecv(rows + (size_t) (sched->y_tail - 1 - h_head) * row_size, row_size, MPI_BYTE, lower, 1,
+		 rows,                                                    row_size, MPI_BYTE, upper, 1,
+		 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+#ifdef BENCHMARK_TEST
+    te = wtime(true);
+    if (myrank == 0)
+	printf("Exchange =%.3f[sec.]\n", te - ts);
+#endif
+
+    return;
+}
+#else				//......................................
+{				// dummy function
+    return;
+}
+#endif
+
 //----------------------------------------------------------------------
 #ifdef VECTOR_LENGTH
 void mandelbrot(int vlen, int iter_max, int * restrict iter,
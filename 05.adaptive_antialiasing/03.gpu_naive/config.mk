@@ -10,6 +10,46 @@ DEVICE	= default
 #........................................................................
 EQVCLR	= relaxed
 #------------------------------------------------------------------------
+# PERSIST: persistent-threads anti-aliasing [no|yes]
+#          work-groups take edge pixels from an atomic work queue,
+#          and work-items of a group share the samples of a pixel.
+#........................................................................
+PERSIST	= no
+#------------------------------------------------------------------------
+# ROUNDS: round-synchronous anti-aliasing [no|yes] (w/o PERSIST)
+#         each doubling round of samples is a launch over the compacted
+#         list of pixels not converged yet.
+#........................................................................
+ROUNDS	= no
+#------------------------------------------------------------------------
+# BUDGET: samples of a pixel per anti-aliasing launch [0|n] (w/o
+#         PERSIST or ROUNDS), 0 for a single launch.
+#         per-pixel state is kept on the device, and launches are
+#         repeated until all pixels converge. SIGINT cancels the rest.
+#........................................................................
+BUDGET	= 0
+#------------------------------------------------------------------------
+# TILE  : rows of a tile for tiled rendering [0|n] (w/o PERSIST,
+#         ROUNDS, BUDGET or SPECIAL), 0 for the whole image.
+#         tiles with halo rows stream through a pool of device buffers,
+#         and read-back of a tile overlaps compute of the next one.
+#........................................................................
+TILE	= 0
+#------------------------------------------------------------------------
+# FUSED : fused tile kernel [no|yes] (w/o PERSIST, ROUNDS, BUDGET, TILE)
+#         a work-group draws the rough sketch of its 16x16 tile with a
+#         one-pixel halo in local memory, and refines edges of the tile
+#         in the same launch (no sketch buffer, at the cost of halos).
+#         kernel time is reported with DATA=benchmark*.
+#........................................................................
+FUSED	= no
+#------------------------------------------------------------------------
+# SPECIAL: JIT specialization of kernels [no|yes]
+#          the image size and view parameters are build options,
+#          and the program binary is cached per parameter set.
+#........................................................................
+SPECIAL	= no
+#------------------------------------------------------------------------
 # SAMPLE: sampling method [halton|hammersley|mt19937|rand]
 #........................................................................
 SAMPLE	= hammersley
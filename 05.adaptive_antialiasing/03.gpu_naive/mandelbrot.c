@@ -4,10 +4,18 @@
  * $Id: mandelbrot.c,v 1.1.1.6 2021/07/21 00:00:00 seiji Exp seiji $
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
 #include <pixmap.h>
 #include <palette.h>
 #include <cl_util.h>
 
+#ifdef BENCHMARK_TEST
+#include <wtime.h>
+#endif
+
 #if   defined(USE_HALTON) || defined(USE_HAMMERSLEY)
 #include <lds.h>
 #elif defined(USE_MT19937)
@@ -20,6 +28,28 @@
 #define MIN_SAMPLES	(0x01<<4)
 #define MAX_SAMPLES	(0x01<<16)
 
+// for persistent threads
+#define PT_LOCAL_SIZE		64	// work-items of a group (same as in KERNEL)
+#define PT_GROUPS_PER_UNIT	4	// work-groups launched per compute unit
+
+// for round-synchronous refinement
+#define SCAN_LOCAL_SIZE		256	// work-items of a prefix sum block (same as in KERNEL)
+
+// for chunked refinement
+#ifndef SAMPLE_BUDGET
+#define SAMPLE_BUDGET		1024	// samples of a pixel per launch
+#endif
+
+// for tiled rendering
+#ifndef TILE_HEIGHT
+#define TILE_HEIGHT		256	// rows of a tile (w/o halo rows)
+#endif
+#define NUM_TILE_BUFS		3	// tiles in flight (buffers and in-order queues)
+
+// for fused tile kernel
+#define TILE_W			16	// work-group size (same as in KERNEL)
+#define TILE_H			16
+
 // uniform RNG for [0:1)
 #if   defined(USE_RAND)
 #define SRAND(s)	srand(s)
@@ -34,12 +64,29 @@ void colormap_init(pixel_t *, int);
 void jitter_init  (double *, double *);
 void draw_image   (cl_obj_t *, pixmap_t *, pixel_t *,
 			int, double, double, double, double *, double *);
+void build_options(char *, size_t, const char *);
+#ifdef USE_TILED_RENDERING
+void draw_tiles   (cl_obj_t *, pixmap_t *, pixel_t *,
+			int, double, double, double, double *, double *);
+#endif
+#if defined(USE_PERSISTENT_THREADS) && defined(BENCHMARK_TEST)
+void occupancy_report(cl_long *, int, int, int);
+#endif
+#ifdef USE_ROUND_SYNC
+int  list_compact(cl_obj_t *, cl_kernel *, cl_mem, cl_mem, cl_mem, cl_mem, int);
+int  prefix_sum  (cl_obj_t *, cl_kernel *, cl_mem, cl_mem, int);
+#endif
+#ifdef USE_SAMPLE_BUDGET
+void on_interrupt(int);
+
+static volatile sig_atomic_t cancelled = 0;	// set by SIGINT
+#endif
 
 //======================================================================
 int main(int argc, char **argv)
 {
     cl_obj_t obj;
-    char    *options =
+    char    *base    =
 #ifdef USE_SAME_COLOR
 		"-DUSE_SAME_COLOR "
 #endif
@@ -48,21 +95,49 @@ int main(int argc, char **argv)
 #else	// SIZEOF_PIXEL_T == 4
 		"-DSIZEOF_PIXEL_T=4";
 #endif
+    char     options[BUFSIZ];
 
     pixmap_t image;
     pixel_t  colormap[ITER_MAX];
     double   dx[MAX_SAMPLES],
 	     dy[MAX_SAMPLES];
+#ifdef BENCHMARK_TEST
+    double   ts, te, tm_init, tm_comp, tm_fin;
+
+    printf("*** Mandelbrot [%dx%d] ***\n", WIDTH, HEIGHT);
+    ts      = wtime(false);
+#endif
 
-    // initialize OpenCL
+    // initialize OpenCL, the program binary may be cached.
+    build_options(options, sizeof(options), base);
     cl_init(&obj, NULL, OPENCL_DEVICE, 0, KERNEL, options);
 
     pixmap_create(&image, WIDTH, HEIGHT);
     colormap_init(colormap, ITER_MAX);
     jitter_init(dx, dy);
 
+#ifdef BENCHMARK_TEST
+    te      = wtime(false);
+    tm_init = te - ts;
+    ts      = te;
+#endif
+
+#ifdef USE_SAMPLE_BUDGET	// SIGINT cancels the rest of refinement.
+    signal(SIGINT, on_interrupt);
+#endif
+
     // draw image
+#ifdef USE_TILED_RENDERING
+    draw_tiles(&obj, &image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy);
+#else
     draw_image(&obj, &image, colormap, ITER_MAX, CENTER_R, CENTER_I, RADIUS, dx, dy);
+#endif
+
+#ifdef BENCHMARK_TEST
+    te      = wtime(false);
+    tm_comp = te - ts;
+    ts      = te;
+#endif
 
     pixmap_write_ppmfile(&image, "output.ppm");
     pixmap_destroy(&image);
@@ -70,6 +145,13 @@ int main(int argc, char **argv)
     // finalize OpenCL
     cl_fin(&obj);
 
+#ifdef BENCHMARK_TEST
+    te      = wtime(false);
+    tm_fin  = te - ts;
+    printf("Init/Comp/Fin=%.3f/%.3f/%.3f[sec.]\n",
+				tm_init, tm_comp, tm_fin);
+#endif
+
     return 0;
 }
 
@@ -130,44 +212,128 @@ void jitter_init(double *dx, double *dy)
 }
 #endif
 
+//----------------------------------------------------------------------
+void build_options(char *options, size_t size, const char *base)
+{				// OpenCL build options. view parameters are given as constants
+				// to specialize the program, which is cached per parameter set.
+    snprintf(options, size, "%s", base);
+
+#ifdef USE_SPECIALIZATION
+    size_t len = strlen(options);
+    snprintf(options + len, size - len,
+	     " -DSPECIALIZED -DWIDTH=%d -DHEIGHT=%d -DITER_MAX=%d"
+	     " -DCENTER_R=%.17g -DCENTER_I=%.17g -DRADIUS=%.17g",
+	     WIDTH, HEIGHT, ITER_MAX, CENTER_R, CENTER_I, RADIUS);
+#endif
+
+    return;
+}
+
 //----------------------------------------------------------------------
 void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
 	int iter_max, double c_r, double c_i, double radius, double *dx, double *dy)
 {
     int              width, height;
-    cl_program       program = cl_query_program(obj);
     cl_command_queue queue   = cl_query_queue  (obj);
+    cl_mem           dev_dx, dev_dy, dev_pixmap, dev_colormap;
+#ifndef USE_FUSED_TILE
     cl_context       context = cl_query_context(obj);
+    cl_mem           dev_sketch;
+#endif
+#if !defined(USE_PERSISTENT_THREADS) && !defined(USE_ROUND_SYNC) && !defined(USE_SAMPLE_BUDGET)
+    cl_program       program = cl_query_program(obj);
     cl_kernel        kernel  = NULL;
-    cl_mem           dev_dx, dev_dy, dev_sketch, dev_pixmap, dev_colormap;
     size_t           global_size[2];
+#endif
+#ifdef USE_FUSED_TILE
+    size_t           local_size [2];
+#endif
+#ifdef BENCHMARK_TEST
+    double           ts;
+#ifndef USE_FUSED_TILE
+    double           tm_sketch;
+#endif
+#endif
     void rough_sketch(cl_obj_t *, cl_mem, int, int, cl_mem, int, double, double, double);
+#if   defined(USE_PERSISTENT_THREADS)
+    void antialiasing_PT(cl_obj_t *, cl_mem, cl_mem, int, int, cl_mem, int, double, double, double, cl_mem, cl_mem);
+#elif defined(USE_ROUND_SYNC)
+    void antialiasing_RS(cl_obj_t *, cl_mem, cl_mem, int, int, cl_mem, int, double, double, double, cl_mem, cl_mem);
+#elif defined(USE_SAMPLE_BUDGET)
+    void antialiasing_CB(cl_obj_t *, cl_mem, cl_mem, int, int, cl_mem, int, double, double, double, cl_mem, cl_mem);
+#endif
 
     pixmap_get_size(image, &width, &height);
 
-    // memory allocation on GPU
-    dev_dx       = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			MAX_SAMPLES    * sizeof(double ), NULL, NULL);
-    dev_dy       = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			MAX_SAMPLES    * sizeof(double ), NULL, NULL);
+    // memory allocation on GPU (host data is used in place on unified memory)
+    dev_dx       = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			MAX_SAMPLES    * sizeof(double ), dx);
+    dev_dy       = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			MAX_SAMPLES    * sizeof(double ), dy);
+#ifndef USE_FUSED_TILE
     dev_sketch   = clCreateBuffer(context, CL_MEM_READ_WRITE,
 			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_pixmap   = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			width * height * sizeof(pixel_t), NULL, NULL);
-    dev_colormap = clCreateBuffer(context, CL_MEM_READ_WRITE,
-			iter_max       * sizeof(pixel_t), NULL, NULL);
+#endif
+    dev_pixmap   = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			width * height * sizeof(pixel_t), image->data);
+    dev_colormap = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			iter_max       * sizeof(pixel_t), colormap);
 
     // CPU->GPU memory copy
-    clEnqueueWriteBuffer(queue, dev_dx      , CL_TRUE, 0,
-			MAX_SAMPLES    * sizeof(double ), dx      , 0, NULL, NULL);
-    clEnqueueWriteBuffer(queue, dev_dy      , CL_TRUE, 0,
-			MAX_SAMPLES    * sizeof(double ), dy      , 0, NULL, NULL);
-    clEnqueueWriteBuffer(queue, dev_colormap, CL_TRUE, 0,
-			iter_max       * sizeof(pixel_t), colormap, 0, NULL, NULL);
+    cl_write_buffer(obj, dev_dx      , 0,
+			MAX_SAMPLES    * sizeof(double ), dx);
+    cl_write_buffer(obj, dev_dy      , 0,
+			MAX_SAMPLES    * sizeof(double ), dy);
+    cl_write_buffer(obj, dev_colormap, 0,
+			iter_max       * sizeof(pixel_t), colormap);
+
+#ifdef BENCHMARK_TEST		// kernels of sketch and refinement are timed.
+    clFinish(queue);
+    ts = wtime(false);
+#endif
+
+#ifdef USE_FUSED_TILE
+    // load kernel function
+    kernel = clCreateKernel(program, "fused_tile_GPU", NULL);
 
+    // set up kernel args for fused rough sketch and antialiasing
+    clSetKernelArg(kernel,  0, sizeof(cl_mem), &dev_pixmap  );
+    clSetKernelArg(kernel,  1, sizeof(int   ), &width       );
+    clSetKernelArg(kernel,  2, sizeof(int   ), &height      );
+    clSetKernelArg(kernel,  3, sizeof(int   ), &height      );	// y_tail
+    clSetKernelArg(kernel,  4, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(kernel,  5, sizeof(int   ), &iter_max    );
+    clSetKernelArg(kernel,  6, sizeof(double), &c_r         );
+    clSetKernelArg(kernel,  7, sizeof(double), &c_i         );
+    clSetKernelArg(kernel,  8, sizeof(double), &radius      );
+    clSetKernelArg(kernel,  9, sizeof(cl_mem), &dev_dx      );
+    clSetKernelArg(kernel, 10, sizeof(cl_mem), &dev_dy      );
+
+    // set up threads: a work-group for a tile
+    global_size[0] = ROUND_UP(width , TILE_W);
+    global_size[1] = ROUND_UP(height, TILE_H);
+    local_size [0] = TILE_W;
+    local_size [1] = TILE_H;
+
+    // calling kernel function
+    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, local_size, 0, NULL, NULL);
+#else
     // draw rough sketch image
     rough_sketch(obj, dev_sketch, width, height, dev_colormap, iter_max, c_r, c_i, radius);
+#ifdef BENCHMARK_TEST
+    tm_sketch = wtime(false) - ts;
+#endif
 
+#if   defined(USE_PERSISTENT_THREADS)
+    antialiasing_PT(obj, dev_pixmap, dev_sketch, width, height,
+		    dev_colormap, iter_max, c_r, c_i, radius, dev_dx, dev_dy);
+#elif defined(USE_ROUND_SYNC)
+    antialiasing_RS(obj, dev_pixmap, dev_sketch, width, height,
+		    dev_colormap, iter_max, c_r, c_i, radius, dev_dx, dev_dy);
+#elif defined(USE_SAMPLE_BUDGET)
+    antialiasing_CB(obj, dev_pixmap, dev_sketch, width, height,
+		    dev_colormap, iter_max, c_r, c_i, radius, dev_dx, dev_dy);
+#else
     // load kernel function
     kernel = clCreateKernel(program, "antialiasing_GPU", NULL);
 
@@ -190,10 +356,21 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
 
     // calling kernel function
     clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+#endif
+#endif
+
+#ifdef BENCHMARK_TEST
+    clFinish(queue);
+#ifdef USE_FUSED_TILE
+    printf("Kernels  =%10.3f[sec.] (fused sketch and refinement)\n", wtime(false) - ts);
+#else
+    printf("Kernels  =%10.3f[sec.] (sketch=%.3f[sec.])\n", wtime(false) - ts, tm_sketch);
+#endif
+#endif
 
     // GPU->CPU memory copy
-    clEnqueueReadBuffer(queue, dev_pixmap, CL_TRUE, 0,
-			width * height * sizeof(pixel_t), image->data, 0, NULL, NULL);
+    cl_read_buffer(obj, dev_pixmap, 0,
+			width * height * sizeof(pixel_t), image->data);
 
     clFlush (queue);
     clFinish(queue);
@@ -201,12 +378,16 @@ void draw_image(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
     // memory deallocation on GPU
     clReleaseMemObject(dev_dx      );
     clReleaseMemObject(dev_dy      );
+#ifndef USE_FUSED_TILE
     clReleaseMemObject(dev_sketch  );
+#endif
     clReleaseMemObject(dev_pixmap  );
     clReleaseMemObject(dev_colormap);
 
+#if !defined(USE_PERSISTENT_THREADS) && !defined(USE_ROUND_SYNC) && !defined(USE_SAMPLE_BUDGET)
     // unload kernel function
     clReleaseKernel(kernel);
+#endif
 
     return;
 }
@@ -249,3 +430,585 @@ void rough_sketch(cl_obj_t *obj, cl_mem dev_sketch, int width, int height,
 
     return;
 }
+
+#ifdef USE_TILED_RENDERING
+//----------------------------------------------------------------------
+void draw_tiles(cl_obj_t *obj, pixmap_t *image, pixel_t *colormap,
+	int iter_max, double c_r, double c_i, double radius, double *dx, double *dy)
+{				// the image is rendered in tiles of rows with a halo row above and below,
+				// and each tile is drawn as an image of its own view. NUM_TILE_BUFS tiles
+				// are in flight on as many in-order queues, so that read-back of a tile
+				// overlaps compute of the next one in a fixed amount of device memory.
+    int              width, height, rows, num_tiles;
+    cl_device_id     device  = cl_query_device (obj);
+    cl_context       context = cl_query_context(obj);
+    cl_program       program = cl_query_program(obj);
+    cl_command_queue queue[NUM_TILE_BUFS];
+    cl_kernel        sketch, kernel;
+    cl_mem           dev_dx, dev_dy, dev_colormap,
+		     dev_sketch[NUM_TILE_BUFS], dev_pixmap[NUM_TILE_BUFS];
+    cl_ulong         max_alloc, max_rows;
+    size_t           tile_size, global_size[2], global_offset[2];
+    double           d;
+
+    pixmap_get_size(image, &width, &height);
+
+    d = 2.0 * radius / ((width < height) ? width : height);
+
+    // rows of a tile within the max. allocation size of the device
+    clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &max_alloc, NULL);
+    max_rows  = max_alloc / ((cl_ulong) width * sizeof(pixel_t));
+    rows      = (max_rows < TILE_HEIGHT + 2) ? (int) max_rows - 2 : TILE_HEIGHT;
+    rows      = (rows < 1     ) ? 1      : rows;
+    rows      = (rows > height) ? height : rows;
+    num_tiles = (height + rows - 1) / rows;
+    tile_size = (size_t) width * (rows + 2) * sizeof(pixel_t);
+
+#ifdef BENCHMARK_TEST
+    printf("Tiles    =%d tiles of %d rows, %d buffers (%.1f MiB on device)\n",
+	   num_tiles, rows, NUM_TILE_BUFS, 2.0 * NUM_TILE_BUFS * tile_size / (1 << 20));
+#endif
+
+    // memory allocation on GPU (host data is used in place on unified memory)
+    dev_dx       = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			MAX_SAMPLES    * sizeof(double ), dx);
+    dev_dy       = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			MAX_SAMPLES    * sizeof(double ), dy);
+    dev_colormap = cl_host_buffer(obj, CL_MEM_READ_WRITE,
+			iter_max       * sizeof(pixel_t), colormap);
+
+    for (int b = 0; b < NUM_TILE_BUFS; b++) {	// a pool of tile buffers
+	dev_sketch[b] = clCreateBuffer(context, CL_MEM_READ_WRITE, tile_size, NULL, NULL);
+	dev_pixmap[b] = clCreateBuffer(context, CL_MEM_READ_WRITE, tile_size, NULL, NULL);
+    }
+
+    // CPU->GPU memory copy
+    cl_write_buffer(obj, dev_dx      , 0,
+			MAX_SAMPLES    * sizeof(double ), dx);
+    cl_write_buffer(obj, dev_dy      , 0,
+			MAX_SAMPLES    * sizeof(double ), dy);
+    cl_write_buffer(obj, dev_colormap, 0,
+			iter_max       * sizeof(pixel_t), colormap);
+
+    // in-order queues of the pool, tiles of a buffer are serialized by its queue.
+    queue[0] = cl_query_queue(obj);
+    for (int b = 1; b < NUM_TILE_BUFS; b++)
+#ifdef CL_UTIL_PROFILE		// events of the queues are profiled as well.
+	queue[b] = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, NULL);
+#else
+	queue[b] = clCreateCommandQueue(context, device, 0, NULL);
+#endif
+
+    // load kernel functions, args are captured at each enqueue.
+    sketch = clCreateKernel(program, "rough_sketch_GPU", NULL);
+    kernel = clCreateKernel(program, "antialiasing_GPU", NULL);
+
+    // set up kernel args common to tiles
+    clSetKernelArg(sketch, 1, sizeof(int   ), &width       );
+    clSetKernelArg(sketch, 3, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(sketch, 4, sizeof(int   ), &iter_max    );
+    clSetKernelArg(sketch, 5, sizeof(double), &c_r         );
+
+    clSetKernelArg(kernel,  2, sizeof(int   ), &width       );
+    clSetKernelArg(kernel,  4, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(kernel,  5, sizeof(int   ), &iter_max    );
+    clSetKernelArg(kernel,  6, sizeof(double), &c_r         );
+    clSetKernelArg(kernel,  9, sizeof(cl_mem), &dev_dx      );
+    clSetKernelArg(kernel, 10, sizeof(cl_mem), &dev_dy      );
+
+    for (int t = 0; t < num_tiles; t++) {
+	int    b      = t % NUM_TILE_BUFS,
+	       y_head = t * rows,	// rows [y_head:y_tail) of image
+	       y_tail = (y_head + rows < height) ? y_head + rows : height,
+	       h_head = (y_head > 0     ) ? y_head - 1 : y_head,	// with halo rows
+	       h_tail = (y_tail < height) ? y_tail + 1 : y_tail,
+	       h      = h_tail - h_head;
+	double t_i    = c_i + d * (height / 2 - h_head - h / 2),	// view of the tile
+	       t_rad  = 0.5 * d * ((width < h) ? width : h);
+
+	// set up kernel args for rough_sketch of the tile
+	clSetKernelArg(sketch, 0, sizeof(cl_mem), &dev_sketch[b]);
+	clSetKernelArg(sketch, 2, sizeof(int   ), &h            );
+	clSetKernelArg(sketch, 6, sizeof(double), &t_i          );
+	clSetKernelArg(sketch, 7, sizeof(double), &t_rad        );
+
+	global_offset[0] = 0;
+	global_offset[1] = 0;
+	global_size  [0] = width;
+	global_size  [1] = h;
+
+	clEnqueueNDRangeKernel(queue[b], sketch, 2, global_offset, global_size, NULL, 0, NULL, NULL);
+
+	// set up kernel args for antialiasing of the rows w/o halo
+	clSetKernelArg(kernel, 0, sizeof(cl_mem), &dev_pixmap[b]);
+	clSetKernelArg(kernel, 1, sizeof(cl_mem), &dev_sketch[b]);
+	clSetKernelArg(kernel, 3, sizeof(int   ), &h            );
+	clSetKernelArg(kernel, 7, sizeof(double), &t_i          );
+	clSetKernelArg(kernel, 8, sizeof(double), &t_rad        );
+
+	global_offset[1] = y_head - h_head;
+	global_size  [1] = y_tail - y_head;
+
+	clEnqueueNDRangeKernel(queue[b], kernel, 2, global_offset, global_size, NULL, 0, NULL, NULL);
+
+	// GPU->CPU memory copy of the tile, overlapped with the next tiles
+	clEnqueueReadBuffer(queue[b], dev_pixmap[b], CL_FALSE,
+			(size_t) (y_head - h_head) * width * sizeof(pixel_t),
+			(size_t) (y_tail - y_head) * width * sizeof(pixel_t),
+			image->data + (size_t) y_head * width, 0, NULL, NULL);
+
+	clFlush(queue[b]);
+    }
+
+    for (int b = 0; b < NUM_TILE_BUFS; b++)
+	clFinish(queue[b]);
+
+    // memory deallocation on GPU
+    clReleaseMemObject(dev_dx      );
+    clReleaseMemObject(dev_dy      );
+    clReleaseMemObject(dev_colormap);
+
+    for (int b = 0; b < NUM_TILE_BUFS; b++) {
+	clReleaseMemObject(dev_sketch[b]);
+	clReleaseMemObject(dev_pixmap[b]);
+    }
+
+    for (int b = 1; b < NUM_TILE_BUFS; b++)
+	clReleaseCommandQueue(queue[b]);
+
+    // unload kernel functions
+    clReleaseKernel(sketch);
+    clReleaseKernel(kernel);
+
+    return;
+}
+#endif
+
+#ifdef USE_PERSISTENT_THREADS
+//......................................................................
+void antialiasing_PT(cl_obj_t *obj, cl_mem dev_pixmap, cl_mem dev_sketch, int width, int height,
+	cl_mem dev_colormap, int iter_max, double c_r, double c_i, double radius, cl_mem dev_dx, cl_mem dev_dy)
+{				// persistent-threads anti-aliasing: edge pixels are compacted
+				// into a work queue, and a fixed number of work-groups take them.
+    cl_program       program = cl_query_program(obj);
+    cl_command_queue queue   = cl_query_queue  (obj);
+    cl_context       context = cl_query_context(obj);
+    cl_kernel        kernel  = NULL;
+    cl_mem           dev_queue, dev_edges, dev_stat;
+    cl_uint          num_units;
+    cl_int           head[2] = { 0, 0 };	// # of edge pixels, head of queue
+    cl_long         *stat;
+    int              num_groups;
+    size_t           global_size[2], local_size[1];
+
+    clGetDeviceInfo(cl_query_device(obj), CL_DEVICE_MAX_COMPUTE_UNITS,
+			sizeof(cl_uint), &num_units, NULL);
+    num_groups = num_units * PT_GROUPS_PER_UNIT;
+
+    if ((stat = (cl_long *) malloc(3 * num_groups * sizeof(cl_long))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+    // memory allocation on GPU
+    dev_queue = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			2              * sizeof(cl_int ), NULL, NULL);
+    dev_edges = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+    dev_stat  = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			3 * num_groups * sizeof(cl_long), NULL, NULL);
+
+    // CPU->GPU memory copy
+    clEnqueueWriteBuffer(queue, dev_queue, CL_TRUE, 0,
+			2              * sizeof(cl_int ), head, 0, NULL, NULL);
+
+    // load kernel function
+    kernel = clCreateKernel(program, "edge_compact_GPU", NULL);
+
+    // set up kernel args for edge compaction
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &dev_pixmap);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &dev_sketch);
+    clSetKernelArg(kernel, 2, sizeof(int   ), &width     );
+    clSetKernelArg(kernel, 3, sizeof(int   ), &height    );
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &dev_queue );
+    clSetKernelArg(kernel, 5, sizeof(cl_mem), &dev_edges );
+
+    // set up threads
+    global_size[0] = width ;
+    global_size[1] = height;
+
+    // calling kernel function
+    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+
+    // unload kernel function
+    clReleaseKernel(kernel);
+
+    // load kernel function
+    kernel = clCreateKernel(program, "antialiasing_PT_GPU", NULL);
+
+    // set up kernel args for antialiasing
+    clSetKernelArg(kernel,  0, sizeof(cl_mem), &dev_pixmap  );
+    clSetKernelArg(kernel,  1, sizeof(cl_mem), &dev_sketch  );
+    clSetKernelArg(kernel,  2, sizeof(int   ), &width       );
+    clSetKernelArg(kernel,  3, sizeof(int   ), &height      );
+    clSetKernelArg(kernel,  4, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(kernel,  5, sizeof(int   ), &iter_max    );
+    clSetKernelArg(kernel,  6, sizeof(double), &c_r         );
+    clSetKernelArg(kernel,  7, sizeof(double), &c_i         );
+    clSetKernelArg(kernel,  8, sizeof(double), &radius      );
+    clSetKernelArg(kernel,  9, sizeof(cl_mem), &dev_dx      );
+    clSetKernelArg(kernel, 10, sizeof(cl_mem), &dev_dy      );
+    clSetKernelArg(kernel, 11, sizeof(cl_mem), &dev_queue   );
+    clSetKernelArg(kernel, 12, sizeof(cl_mem), &dev_edges   );
+    clSetKernelArg(kernel, 13, sizeof(cl_mem), &dev_stat    );
+
+    // set up persistent threads
+    global_size[0] = num_groups * PT_LOCAL_SIZE;
+    local_size [0] =              PT_LOCAL_SIZE;
+
+    // calling kernel function
+    clEnqueueNDRangeKernel(queue, kernel, 1, NULL, global_size, local_size, 0, NULL, NULL);
+
+#ifdef BENCHMARK_TEST
+    // GPU->CPU memory copy of statistics
+    clEnqueueReadBuffer(queue, dev_queue, CL_TRUE, 0,
+			2              * sizeof(cl_int ), head, 0, NULL, NULL);
+    clEnqueueReadBuffer(queue, dev_stat , CL_TRUE, 0,
+			3 * num_groups * sizeof(cl_long), stat, 0, NULL, NULL);
+
+    occupancy_report(stat, num_groups, head[0], width * height);
+#endif
+
+    // memory deallocation on GPU
+    clReleaseMemObject(dev_queue);
+    clReleaseMemObject(dev_edges);
+    clReleaseMemObject(dev_stat );
+
+    // unload kernel function
+    clReleaseKernel(kernel);
+
+    free(stat);
+
+    return;
+}
+
+#ifdef BENCHMARK_TEST
+//----------------------------------------------------------------------
+void occupancy_report(cl_long *stat, int num_groups, int num_edges, int num_pixels)
+{				// work done by persistent work-groups in a launch:
+				// stat[3*g+0:3*g+2] = pixels, samples, sample slots of group g.
+    cl_long p_min = stat[0], p_max = 0, p_sum = 0,
+	    s_min = stat[1], s_max = 0, s_sum = 0, slots = 0;
+
+    for (int g = 0; g < num_groups; g++) {
+	cl_long p = stat[3 * g], s = stat[3 * g + 1];
+	p_min  = (p < p_min) ? p : p_min;
+	p_max  = (p > p_max) ? p : p_max;
+	s_min  = (s < s_min) ? s : s_min;
+	s_max  = (s > s_max) ? s : s_max;
+	p_sum += p;
+	s_sum += s;
+	slots += stat[3 * g + 2];
+    }
+
+    printf("Edges    =%d/%d pixels (%.1f%%), %d groups x %d work-items\n",
+	   num_edges, num_pixels, 100.0 * num_edges / num_pixels, num_groups, PT_LOCAL_SIZE);
+    printf("Pixels   =%ld/%.1f/%ld, Samples=%ld/%.1f/%ld (min/avg/max per group)\n",
+	   (long) p_min, (double) p_sum / num_groups, (long) p_max,
+	   (long) s_min, (double) s_sum / num_groups, (long) s_max);
+    if (s_max > 0)		// the tail of launch is as long as the busiest group.
+	printf("Occupancy=%5.1f%% (avg/max samples per group), Lanes=%5.1f%% (samples/slots)\n",
+	       100.0 * s_sum / ((double) s_max * num_groups), 100.0 * s_sum / slots);
+
+    return;
+}
+#endif
+#endif
+
+#ifdef USE_ROUND_SYNC
+//......................................................................
+void antialiasing_RS(cl_obj_t *obj, cl_mem dev_pixmap, cl_mem dev_sketch, int width, int height,
+	cl_mem dev_colormap, int iter_max, double c_r, double c_i, double radius, cl_mem dev_dx, cl_mem dev_dy)
+{				// round-synchronous anti-aliasing: each doubling round of samples is
+				// a launch over the compacted list of pixels not converged yet.
+    cl_program       program = cl_query_program(obj);
+    cl_command_queue queue   = cl_query_queue  (obj);
+    cl_context       context = cl_query_context(obj);
+    cl_kernel        kernel, refine, scan[3];
+    cl_mem           dev_sum, dev_list, dev_next, dev_flag, dev_scan, dev_swap;
+    int              count = width * height, survivors;
+#ifdef BENCHMARK_TEST
+    int              num_edges;
+#endif
+    size_t           global_size[2];
+
+    // memory allocation on GPU
+    dev_sum  = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int4), NULL, NULL);
+    dev_list = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+    dev_next = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+    dev_flag = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+    dev_scan = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+
+    // load kernel functions
+    kernel  = clCreateKernel(program, "edge_flag_GPU"   , NULL);
+    refine  = clCreateKernel(program, "refine_round_GPU", NULL);
+    scan[0] = clCreateKernel(program, "scan_block_GPU"  , NULL);
+    scan[1] = clCreateKernel(program, "scan_add_GPU"    , NULL);
+    scan[2] = clCreateKernel(program, "compact_GPU"     , NULL);
+
+    // set up kernel args for edge detection
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &dev_pixmap);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &dev_sketch);
+    clSetKernelArg(kernel, 2, sizeof(int   ), &width     );
+    clSetKernelArg(kernel, 3, sizeof(int   ), &height    );
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &dev_sum   );
+    clSetKernelArg(kernel, 5, sizeof(cl_mem), &dev_list  );
+    clSetKernelArg(kernel, 6, sizeof(cl_mem), &dev_flag  );
+
+    // set up threads
+    global_size[0] = width ;
+    global_size[1] = height;
+
+    // calling kernel function (round 0)
+    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+
+    // set up kernel args for refinement rounds
+    clSetKernelArg(refine,  0, sizeof(cl_mem), &dev_pixmap  );
+    clSetKernelArg(refine,  1, sizeof(int   ), &width       );
+    clSetKernelArg(refine,  2, sizeof(int   ), &height      );
+    clSetKernelArg(refine,  3, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(refine,  4, sizeof(int   ), &iter_max    );
+    clSetKernelArg(refine,  5, sizeof(double), &c_r         );
+    clSetKernelArg(refine,  6, sizeof(double), &c_i         );
+    clSetKernelArg(refine,  7, sizeof(double), &radius      );
+    clSetKernelArg(refine,  8, sizeof(cl_mem), &dev_dx      );
+    clSetKernelArg(refine,  9, sizeof(cl_mem), &dev_dy      );
+    clSetKernelArg(refine, 10, sizeof(cl_mem), &dev_sum     );
+    clSetKernelArg(refine, 12, sizeof(cl_mem), &dev_flag    );
+
+    survivors = list_compact(obj, scan, dev_list, dev_flag, dev_scan, dev_next, count);
+#ifdef BENCHMARK_TEST
+    num_edges = survivors;
+    printf("Edges    =%d/%d pixels (%.1f%%)\n", num_edges, count, 100.0 * num_edges / count);
+#endif
+
+    for (int round = 1, m = 1, n = MIN_SAMPLES; (count = survivors) > 0; round++, n = (m = n) << 0x01) {
+	// pixels of the last round
+	dev_swap = dev_list; dev_list = dev_next; dev_next = dev_swap;
+
+#ifdef BENCHMARK_TEST
+	printf("Round%3d : samples=[%5d:%5d), pixels=%8d (%5.1f%%)\n",
+	       round, m, n, count, 100.0 * count / num_edges);
+#endif
+
+	clSetKernelArg(refine, 11, sizeof(cl_mem), &dev_list);
+	clSetKernelArg(refine, 13, sizeof(int   ), &m       );
+	clSetKernelArg(refine, 14, sizeof(int   ), &n       );
+
+	global_size[0] = count;
+
+	// calling kernel function
+	clEnqueueNDRangeKernel(queue, refine, 1, NULL, global_size, NULL, 0, NULL, NULL);
+
+	survivors = list_compact(obj, scan, dev_list, dev_flag, dev_scan, dev_next, count);
+    }
+
+    clFlush (queue);
+    clFinish(queue);
+
+    // memory deallocation on GPU
+    clReleaseMemObject(dev_sum );
+    clReleaseMemObject(dev_list);
+    clReleaseMemObject(dev_next);
+    clReleaseMemObject(dev_flag);
+    clReleaseMemObject(dev_scan);
+
+    // unload kernel functions
+    clReleaseKernel(kernel );
+    clReleaseKernel(refine );
+    clReleaseKernel(scan[0]);
+    clReleaseKernel(scan[1]);
+    clReleaseKernel(scan[2]);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+int list_compact(cl_obj_t *obj, cl_kernel *scan,
+	cl_mem dev_list, cl_mem dev_flag, cl_mem dev_scan, cl_mem dev_next, int count)
+{				// flagged entries of list[0:count) are packed into next.
+    cl_command_queue queue = cl_query_queue(obj);
+    size_t           global_size[1] = { count };
+    int              total = prefix_sum(obj, scan, dev_flag, dev_scan, count);
+
+    // set up kernel args for compaction
+    clSetKernelArg(scan[2], 0, sizeof(cl_mem), &dev_list);
+    clSetKernelArg(scan[2], 1, sizeof(cl_mem), &dev_flag);
+    clSetKernelArg(scan[2], 2, sizeof(cl_mem), &dev_scan);
+    clSetKernelArg(scan[2], 3, sizeof(cl_mem), &dev_next);
+
+    // calling kernel function
+    clEnqueueNDRangeKernel(queue, scan[2], 1, NULL, global_size, NULL, 0, NULL, NULL);
+
+    return total;
+}
+
+//----------------------------------------------------------------------
+int prefix_sum(cl_obj_t *obj, cl_kernel *scan, cl_mem dev_in, cl_mem dev_out, int count)
+{				// exclusive prefix sum of in[0:count) into out, and its total.
+				// block sums are scanned recursively.
+    cl_command_queue queue      = cl_query_queue  (obj);
+    cl_context       context    = cl_query_context(obj);
+    int              num_blocks = (count + SCAN_LOCAL_SIZE - 1) / SCAN_LOCAL_SIZE, total;
+    size_t           global_size[1] = { num_blocks * SCAN_LOCAL_SIZE },
+		     local_size [1] = {              SCAN_LOCAL_SIZE };
+    cl_mem           dev_sum, dev_offset;
+
+    dev_sum    = clCreateBuffer(context, CL_MEM_READ_WRITE, num_blocks * sizeof(cl_int), NULL, NULL);
+    dev_offset = clCreateBuffer(context, CL_MEM_READ_WRITE, num_blocks * sizeof(cl_int), NULL, NULL);
+
+    // set up kernel args for scan in blocks
+    clSetKernelArg(scan[0], 0, sizeof(cl_mem), &dev_in );
+    clSetKernelArg(scan[0], 1, sizeof(cl_mem), &dev_out);
+    clSetKernelArg(scan[0], 2, sizeof(cl_mem), &dev_sum);
+    clSetKernelArg(scan[0], 3, sizeof(int   ), &count  );
+
+    // calling kernel function
+    clEnqueueNDRangeKernel(queue, scan[0], 1, NULL, global_size, local_size, 0, NULL, NULL);
+
+    if (num_blocks == 1)	// GPU->CPU memory copy of the total
+	clEnqueueReadBuffer(queue, dev_sum, CL_TRUE, 0, sizeof(cl_int), &total, 0, NULL, NULL);
+    else {
+	total = prefix_sum(obj, scan, dev_sum, dev_offset, num_blocks);
+
+	// set up kernel args for offsets of blocks
+	clSetKernelArg(scan[1], 0, sizeof(cl_mem), &dev_out   );
+	clSetKernelArg(scan[1], 1, sizeof(cl_mem), &dev_offset);
+	clSetKernelArg(scan[1], 2, sizeof(int   ), &count     );
+
+	// calling kernel function
+	clEnqueueNDRangeKernel(queue, scan[1], 1, NULL, global_size, local_size, 0, NULL, NULL);
+    }
+
+    clReleaseMemObject(dev_sum   );
+    clReleaseMemObject(dev_offset);
+
+    return total;
+}
+#endif
+
+#ifdef USE_SAMPLE_BUDGET
+//......................................................................
+void antialiasing_CB(cl_obj_t *obj, cl_mem dev_pixmap, cl_mem dev_sketch, int width, int height,
+	cl_mem dev_colormap, int iter_max, double c_r, double c_i, double radius, cl_mem dev_dx, cl_mem dev_dy)
+{				// chunked anti-aliasing: a launch takes up to SAMPLE_BUDGET samples of
+				// each pixel, and per-pixel state is kept for the next launch. the queue
+				// is free between launches, and refinement stops when cancelled.
+    cl_program       program = cl_query_program(obj);
+    cl_command_queue queue   = cl_query_queue  (obj);
+    cl_context       context = cl_query_context(obj);
+    cl_kernel        kernel, refine;
+    cl_mem           dev_sum, dev_state, dev_remain;
+    cl_int           remain  = 0;
+    int              budget  = SAMPLE_BUDGET, chunk;
+#ifdef BENCHMARK_TEST
+    int              count   = width * height, num_edges;
+#endif
+    size_t           global_size[2];
+
+    // memory allocation on GPU
+    dev_sum    = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int4), NULL, NULL);
+    dev_state  = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			width * height * sizeof(cl_int ), NULL, NULL);
+    dev_remain = clCreateBuffer(context, CL_MEM_READ_WRITE,
+			1              * sizeof(cl_int ), NULL, NULL);
+
+    // load kernel functions
+    kernel = clCreateKernel(program, "chunk_init_GPU"  , NULL);
+    refine = clCreateKernel(program, "chunk_refine_GPU", NULL);
+
+    // set up kernel args for edge detection
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &dev_pixmap);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &dev_sketch);
+    clSetKernelArg(kernel, 2, sizeof(int   ), &width     );
+    clSetKernelArg(kernel, 3, sizeof(int   ), &height    );
+    clSetKernelArg(kernel, 4, sizeof(cl_mem), &dev_sum   );
+    clSetKernelArg(kernel, 5, sizeof(cl_mem), &dev_state );
+    clSetKernelArg(kernel, 6, sizeof(cl_mem), &dev_remain);
+
+    // set up kernel args for refinement chunks
+    clSetKernelArg(refine,  0, sizeof(cl_mem), &dev_pixmap  );
+    clSetKernelArg(refine,  1, sizeof(int   ), &width       );
+    clSetKernelArg(refine,  2, sizeof(int   ), &height      );
+    clSetKernelArg(refine,  3, sizeof(cl_mem), &dev_colormap);
+    clSetKernelArg(refine,  4, sizeof(int   ), &iter_max    );
+    clSetKernelArg(refine,  5, sizeof(double), &c_r         );
+    clSetKernelArg(refine,  6, sizeof(double), &c_i         );
+    clSetKernelArg(refine,  7, sizeof(double), &radius      );
+    clSetKernelArg(refine,  8, sizeof(cl_mem), &dev_dx      );
+    clSetKernelArg(refine,  9, sizeof(cl_mem), &dev_dy      );
+    clSetKernelArg(refine, 10, sizeof(cl_mem), &dev_sum     );
+    clSetKernelArg(refine, 11, sizeof(cl_mem), &dev_state   );
+    clSetKernelArg(refine, 12, sizeof(cl_mem), &dev_remain  );
+    clSetKernelArg(refine, 13, sizeof(int   ), &budget      );
+
+    // set up threads
+    global_size[0] = width ;
+    global_size[1] = height;
+
+    // calling kernel function (chunk 0)
+    clEnqueueWriteBuffer(queue, dev_remain, CL_TRUE, 0, sizeof(cl_int), &remain, 0, NULL, NULL);
+    clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global_size, NULL, 0, NULL, NULL);
+    clEnqueueReadBuffer (queue, dev_remain, CL_TRUE, 0, sizeof(cl_int), &remain, 0, NULL, NULL);
+
+#ifdef BENCHMARK_TEST
+    num_edges = remain;
+    printf("Edges    =%d/%d pixels (%.1f%%)\n", num_edges, count, 100.0 * num_edges / count);
+#endif
+
+    for (chunk = 1; remain > 0 && !cancelled; chunk++) {
+	cl_int zero = 0;
+
+	// calling kernel function, and counting pixels left to be refined
+	clEnqueueWriteBuffer(queue, dev_remain, CL_TRUE, 0, sizeof(cl_int), &zero, 0, NULL, NULL);
+	clEnqueueNDRangeKernel(queue, refine, 2, NULL, global_size, NULL, 0, NULL, NULL);
+	clEnqueueReadBuffer (queue, dev_remain, CL_TRUE, 0, sizeof(cl_int), &remain, 0, NULL, NULL);
+
+#ifdef BENCHMARK_TEST
+	printf("Chunk%4d : samples<=%6d, pixels=%8d (%5.1f%%)\n",
+	       chunk, chunk * budget, remain, 100.0 * remain / num_edges);
+#endif
+    }
+
+    if (remain > 0)		// the image has averages of the last doubling.
+	printf("Cancelled: %d pixels are left unconverged after %d chunks.\n", remain, chunk - 1);
+
+    clFlush (queue);
+    clFinish(queue);
+
+    // memory deallocation on GPU
+    clReleaseMemObject(dev_sum   );
+    clReleaseMemObject(dev_state );
+    clReleaseMemObject(dev_remain);
+
+    // unload kernel functions
+    clReleaseKernel(kernel);
+    clReleaseKernel(refine);
+
+    return;
+}
+
+//......................................................................
+void on_interrupt(int sig)
+{				// cancel refinement at the end of the current chunk.
+    cancelled = 1;
+
+    return;
+}
+#endif
@@ -6,46 +6,97 @@
 
 #pragma OPENCL EXTENSION cl_khr_fp64 : enable
 
+#ifndef VLEN			// vector length [2|4|8|16] given by build options
 #define VLEN	4
+#endif
 #define BAILOUT	4.0
 
+// vector types and functions of VLEN
+#define CONCAT_(a,b)	a ## b
+#define CONCAT(a,b)	CONCAT_(a,b)
+#define intV		CONCAT(int          , VLEN)
+#define doubleV		CONCAT(double       , VLEN)
+#define vloadV		CONCAT(vload        , VLEN)
+#define vstoreV		CONCAT(vstore       , VLEN)
+#define convert_intV	CONCAT(convert_int   , VLEN)
+#define convert_doubleV	CONCAT(convert_double, VLEN)
+
+#if   VLEN == 2
+#define LANES	((int2 ) (0, 1))
+#elif VLEN == 4
+#define LANES	((int4 ) (0, 1, 2, 3))
+#elif VLEN == 8
+#define LANES	((int8 ) (0, 1, 2, 3, 4, 5, 6, 7))
+#elif VLEN == 16
+#define LANES	((int16) (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15))
+#endif
+
 // for adaptive anti-aliasing
 #define MIN_SAMPLES	(0x01<<4)
 #define MAX_SAMPLES	(0x01<<16)
 
-inline int4    mandelbrot      (int, double4, double4);
+// for persistent threads: work-items of a group share samples of a pixel.
+#define PT_LOCAL_SIZE	64	// power of two
+
+// for round-synchronous refinement: prefix sum in blocks of a work-group.
+#define SCAN_LOCAL_SIZE	256	// power of two
+
+// for fused tile kernel
+#define TILE_W	16		// work-group size (same as in host code)
+#define TILE_H	16
+#define HALO_W	(TILE_W + 2)	// tile with one-pixel halo
+#define HALO_H	(TILE_H + 2)
+
+// view parameters of kernel args can be specialized as constants by build
+// options, so that the compiler folds them.
+#ifdef SPECIALIZED
+#define SPECIALIZE_SIZE()	(width    = WIDTH   , height = HEIGHT)
+#define SPECIALIZE_VIEW()	(iter_max = ITER_MAX, c_r    = CENTER_R, c_i = CENTER_I, radius = RADIUS)
+#else
+#define SPECIALIZE_SIZE()
+#define SPECIALIZE_VIEW()
+#endif
+
+inline intV    mandelbrot      (int, doubleV, doubleV);
+inline uchar4  refine_pixel    (__global uchar *, int, double, double, double,
+				int, int, int, int, __global double *, __global double *, uchar4);
 inline bool    detect_edge     (__global uchar *, uchar4 *, int, int, int, int);
+inline bool    detect_edge_tile(__local  uchar4 *, uchar4 *, int, int);
 inline bool    equivalent_color(uchar4, uchar4);
 inline uchar4  pixmap_get_pixel(__global uchar *, int, int, int);
-inline uchar16 colormap_lookup (__global uchar *, int4);
+inline int4    colormap_sum    (__global uchar *, intV);
 
 //----------------------------------------------------------------------
 __kernel void rough_sketch_GPU
 	(__global uchar *pixmap  , int width, int height,
 	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius)
 {
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
     int     x = get_global_id(0) * VLEN,
 	    y = get_global_id(1);
     double  d = 2.0 * radius / min(width, height);
-    double4 p_r, p_i;
+    doubleV p_r, p_i;
+    int     index[VLEN];
 
     if (x > width - VLEN)	// to deal with vector remainder
 	x = width - VLEN;
 
-    p_r = c_r + d * convert_double4(x - width  / 2 + (int4) (0, 1, 2, 3));
+    p_r = c_r + d * convert_doubleV(x - width  / 2 + LANES);
     p_i = c_i + d * convert_double (height / 2 - y);
 
-    int4     iter  = mandelbrot(iter_max, p_r, p_i);
+    intV     iter  = mandelbrot(iter_max, p_r, p_i);
 
-    uchar16  pixel = colormap_lookup(colormap, iter % iter_max);
+    vstoreV(iter % iter_max, 0, index);
+    for (int j = 0; j < VLEN; j++) {
+	uchar4 pixel = pixmap_get_pixel(colormap, index[j], 0, 0);
 #if        SIZEOF_PIXEL_T == 3
-    vstore3 (pixel.s123, x + 0 + y * width, pixmap);
-    vstore3 (pixel.s567, x + 1 + y * width, pixmap);
-    vstore3 (pixel.s9ab, x + 2 + y * width, pixmap);
-    vstore3 (pixel.sdef, x + 3 + y * width, pixmap);
+	vstore3(pixel.s123, x + j + y * width, pixmap);
 #else	// SIZEOF_PIXEL_T == 4
-    vstore16(pixel, 0, pixmap + SIZEOF_PIXEL_T * (x + y * width));
+	vstore4(pixel     , x + j + y * width, pixmap);
 #endif
+    }
 
     return;
 }
@@ -55,38 +106,382 @@ __kernel void antialiasing_GPU
 	(__global uchar *pixmap  , __global uchar *sketch, int width, int height,
 	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius, __global double *dx, __global double *dy)
 {
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
 #if 1
     int x = get_global_id(0),
 	y = get_global_id(1);
-#else
-    int x = get_group_id(0) + get_num_groups(0) * get_local_id(0),
-	y = get_group_id(1) + get_num_groups(1) * get_local_id(1);
+#else				// group IDs do not include the global offset.
+    int x = get_global_offset(0) + get_group_id(0) + get_num_groups(0) * get_local_id(0),
+	y = get_global_offset(1) + get_group_id(1) + get_num_groups(1) * get_local_id(1);
+#endif
+    uchar4 pixel;
+
+    if (detect_edge(sketch, &pixel, x, y, width, height))	// over-sampling for edge
+	pixel = refine_pixel(colormap, iter_max, c_r, c_i, radius,
+			     x, y, width, height, dx, dy, pixel);
+
+#if        SIZEOF_PIXEL_T == 3
+    vstore3(pixel.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+    vstore4(pixel     , x + y * width, pixmap);
 #endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void fused_tile_GPU
+	(__global uchar *pixmap  , int width, int height, int y_tail,
+	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius, __global double *dx, __global double *dy)
+{				// rough sketch of the tile and its halo is drawn in local memory,
+				// VLEN points at a time, and edge pixels of the tile are refined
+				// in the same launch.
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
+    __local uchar4 tile[HALO_W * HALO_H];
+    int    x  = get_global_id(0),
+	   y  = get_global_id(1),
+	   x0 = x - get_local_id(0) - 1,	// origin of the tile with halo
+	   y0 = y - get_local_id(1) - 1;	// (group IDs do not include the global offset.)
+    double d  = 2.0 * radius / min(width, height);
+    int    index[VLEN];
+    uchar4 pixel;
+
+    // halo out of the image is clamped to the border, which does not change edges.
+    for (int k = VLEN * (get_local_id(0) + get_local_id(1) * TILE_W); k < HALO_W * HALO_H; k += VLEN * TILE_W * TILE_H) {
+	intV kv = min(k + LANES, HALO_W * HALO_H - 1),	// to deal with vector remainder
+	     sx = clamp(x0 + kv % HALO_W, 0, width  - 1),
+	     sy = clamp(y0 + kv / HALO_W, 0, height - 1);
+	intV iter = mandelbrot(iter_max, c_r + d * convert_doubleV(sx - width  / 2),
+					 c_i + d * convert_doubleV(height / 2 - sy));
+
+	vstoreV(iter % iter_max, 0, index);
+	for (int j = 0; j < VLEN && k + j < HALO_W * HALO_H; j++)
+	    tile[k + j] = pixmap_get_pixel(colormap, index[j], 0, 0);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (x >= width || y >= y_tail)	// out of the row block
+	return;
+
+    if (detect_edge_tile(tile, &pixel, get_local_id(0) + 1, get_local_id(1) + 1))
+	pixel = refine_pixel(colormap, iter_max, c_r, c_i, radius,
+			     x, y, width, height, dx, dy, pixel);
+
+#if        SIZEOF_PIXEL_T == 3
+    vstore3(pixel.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+    vstore4(pixel     , x + y * width, pixmap);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void edge_compact_GPU
+	(__global uchar *pixmap, __global uchar *sketch, int width, int height,
+	 __global int   *queue , __global int   *edges)
+{				// compact edge pixels into the list edges[0:queue[0]),
+				// and copy the others from the sketch.
+    SPECIALIZE_SIZE();
+
+    int x = get_global_id(0),
+	y = get_global_id(1);
     uchar4 pixel;
 
-    if (detect_edge(sketch, &pixel, x, y, width, height)) {	// over-sampling for edge
-	uchar4 average  = pixel;
-	int4   sum      = 0;
+    if (detect_edge(sketch, &pixel, x, y, width, height))
+	edges[atomic_inc(&queue[0])] = x + y * width;
+    else
+#if        SIZEOF_PIXEL_T == 3
+	vstore3(pixel.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+	vstore4(pixel     , x + y * width, pixmap);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel __attribute__((reqd_work_group_size(PT_LOCAL_SIZE, 1, 1)))
+void antialiasing_PT_GPU
+	(__global uchar *pixmap  , __global uchar *sketch, int width, int height,
+	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius, __global double *dx, __global double *dy,
+	 __global int   *queue   , __global int   *edges , __global long *stat)
+{				// persistent threads: a fixed number of work-groups take edge
+				// pixels one by one from the queue (queue[1] is the head), and
+				// work-items of a group share VLEN samples at a time.
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
+    __local int  next;
+    __local bool done;
+    __local int4 part[PT_LOCAL_SIZE];
+    int    lid     = get_local_id(0);
+    long   pixels  = 0, samples = 0, slots = 0;
+    double d       = 2.0 * radius / min(width, height);
+
+    for (;;) {
+	if (lid == 0)
+	    next = atomic_inc(&queue[1]);
+	barrier(CLK_LOCAL_MEM_FENCE);
+	if (next >= queue[0])	// uniform in the group
+	    break;
+
+	int    x      = edges[next] % width,
+	       y      = edges[next] / width;
+	uchar4 pixel  = pixmap_get_pixel(sketch, x, y, width),
+	       average = pixel;
+	int4   sum    = 0;	// partial sum of this work-item
 	int    m = 0, n = MIN_SAMPLES;
-	double d = 2.0 * radius / min(width, height);
-	c_r += d * (x - width  / 2),
-	c_i += d * (height / 2 - y);
-	do {
-	    int16 sum4 = 0;
-	    for (int k = m; k < n; k += VLEN) {
-		double4 p_r = c_r + d * vload4(k >> 2, dx),
-			p_i = c_i - d * vload4(k >> 2, dy);
-		int4   iter = mandelbrot(iter_max, p_r, p_i);
-		sum4 += convert_int16(colormap_lookup(colormap, iter % iter_max));
+	double p_r0   = c_r + d * (x - width  / 2),
+	       p_i0   = c_i + d * (height / 2 - y);
+
+	for (;;) {
+	    for (int k = m + VLEN * lid; k < n; k += VLEN * PT_LOCAL_SIZE) {
+		doubleV p_r = p_r0 + d * vloadV(k / VLEN, dx),
+			p_i = p_i0 - d * vloadV(k / VLEN, dy);
+		intV   iter = mandelbrot(iter_max, p_r, p_i);
+		sum += colormap_sum(colormap, iter % iter_max);
+	    }
+	    part[lid] = sum;	// reduction of partial sums in the group
+	    barrier(CLK_LOCAL_MEM_FENCE);
+	    for (int s = PT_LOCAL_SIZE >> 1; s > 0; s >>= 0x01) {
+		if (lid < s)
+		    part[lid] += part[lid + s];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	    }
+	    if (lid == 0) {
+		pixel    = average;
+		average  = convert_uchar4_sat((part[0] + (n >> 1)) / n);
+		done     = equivalent_color(average, pixel) || (n << 0x01) > MAX_SAMPLES;
+		samples += n - m;
+		slots   += (n - m + VLEN * PT_LOCAL_SIZE - 1) / (VLEN * PT_LOCAL_SIZE) * (VLEN * PT_LOCAL_SIZE);
+	    }
+	    barrier(CLK_LOCAL_MEM_FENCE);
+	    if (done)		// uniform in the group
+		break;
+	    n = (m = n) << 0x01;
+	}
+
+	if (lid == 0) {
+	    pixels++;
+#if        SIZEOF_PIXEL_T == 3
+	    vstore3(average.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+	    vstore4(average     , x + y * width, pixmap);
+#endif
+	}
+    }
+
+    if (lid == 0) {		// occupancy statistics of this group
+	stat[3 * get_group_id(0) + 0] = pixels ;
+	stat[3 * get_group_id(0) + 1] = samples;
+	stat[3 * get_group_id(0) + 2] = slots  ;
+    }
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void edge_flag_GPU
+	(__global uchar *pixmap, __global uchar *sketch, int width, int height,
+	 __global int4  *sum   , __global int   *list  , __global int *flag)
+{				// round 0: flag edge pixels in the list of all pixels of the row block.
+				// pixmap holds the sketch as the current average of pixels.
+    SPECIALIZE_SIZE();
+
+    int x = get_global_id(0),
+	y = get_global_id(1),
+	i = x + (y - get_global_offset(1)) * width;
+    uchar4 pixel;
+
+    list[i] = x + y * width;
+    flag[i] = detect_edge(sketch, &pixel, x, y, width, height);
+    sum [x + y * width] = 0;
+
+#if        SIZEOF_PIXEL_T == 3
+    vstore3(pixel.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+    vstore4(pixel     , x + y * width, pixmap);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void refine_round_GPU
+	(__global uchar *pixmap  , int width, int height,
+	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius, __global double *dx, __global double *dy,
+	 __global int4  *sum     , __global int *list, __global int *flag, int m, int n)
+{				// a refinement round: samples [m:n) of the i-th pixel in the list.
+				// flag[i] = 1 if the pixel has not converged yet.
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
+    int    i = get_global_id(0),
+	   x = list[i] % width,
+	   y = list[i] / width;
+    double d = 2.0 * radius / min(width, height);
+    double p_r0 = c_r + d * (x - width  / 2),
+	   p_i0 = c_i + d * (height / 2 - y);
+    int4   s = sum[list[i]];
+
+    for (int k = m; k < n; k += VLEN) {
+	doubleV p_r = p_r0 + d * vloadV(k / VLEN, dx),
+		p_i = p_i0 - d * vloadV(k / VLEN, dy);
+	intV   iter = mandelbrot(iter_max, p_r, p_i);
+	s += colormap_sum(colormap, iter % iter_max);
+    }
+    sum[list[i]] = s;
+
+    uchar4 pixel   = pixmap_get_pixel(pixmap, x, y, width),
+	   average = convert_uchar4_sat((s + (n >> 1)) / n);
+
+    flag[i] = !equivalent_color(average, pixel) && (n << 0x01) <= MAX_SAMPLES;
+
+#if        SIZEOF_PIXEL_T == 3
+    vstore3(average.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+    vstore4(average     , x + y * width, pixmap);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel __attribute__((reqd_work_group_size(SCAN_LOCAL_SIZE, 1, 1)))
+void scan_block_GPU
+	(__global int *in, __global int *out, __global int *block_sum, int count)
+{				// exclusive prefix sum in each block of a work-group,
+				// and the total of the block.
+    __local int part[SCAN_LOCAL_SIZE];
+    int i   = get_global_id(0),
+	lid = get_local_id (0),
+	v   = (i < count) ? in[i] : 0;
+
+    part[lid] = v;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int s = 1; s < SCAN_LOCAL_SIZE; s <<= 0x01) {	// inclusive scan
+	int t = (lid >= s) ? part[lid - s] : 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	part[lid] += t;
+	barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (i < count)
+	out[i] = part[lid] - v;
+    if (lid == SCAN_LOCAL_SIZE - 1)
+	block_sum[get_group_id(0)] = part[lid];
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel __attribute__((reqd_work_group_size(SCAN_LOCAL_SIZE, 1, 1)))
+void scan_add_GPU
+	(__global int *out, __global int *block_offset, int count)
+{				// add the offset of each block to its prefix sums.
+    int i = get_global_id(0);
+
+    if (i < count)
+	out[i] += block_offset[get_group_id(0)];
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void compact_GPU
+	(__global int *list, __global int *flag, __global int *scan, __global int *next)
+{				// flagged entries of the list are packed into the next list.
+    int i = get_global_id(0);
+
+    if (flag[i])
+	next[scan[i]] = list[i];
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void chunk_init_GPU
+	(__global uchar *pixmap, __global uchar *sketch, int width, int height,
+	 __global int4 *sum, __global int *state, __global int *remain)
+{				// chunked anti-aliasing: an edge pixel starts with no samples,
+				// and the others are done (state = # of samples taken, or -1 if done).
+    SPECIALIZE_SIZE();
+
+    int    x = get_global_id(0),
+	   y = get_global_id(1);
+    uchar4 pixel;
+    bool   edge = detect_edge(sketch, &pixel, x, y, width, height);
+
+    sum  [x + y * width] = 0;
+    state[x + y * width] = edge ? 0 : -1;
+
+    if (edge)
+	atomic_inc(remain);
+
+#if        SIZEOF_PIXEL_T == 3
+    vstore3(pixel.s123, x + y * width, pixmap);
+#else	// SIZEOF_PIXEL_T == 4
+    vstore4(pixel     , x + y * width, pixmap);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+__kernel void chunk_refine_GPU
+	(__global uchar *pixmap  , int width, int height,
+	 __global uchar *colormap, int iter_max, double c_r, double c_i, double radius,
+	 __global double *dx, __global double *dy,
+	 __global int4 *sum, __global int *state, __global int *remain, int budget)
+{				// chunked anti-aliasing: up to budget samples of a pixel in a launch,
+				// VLEN samples at a time, resumed from the state left by the last launch.
+				// pixmap holds the average at the end of the last doubling of samples.
+    SPECIALIZE_SIZE();
+    SPECIALIZE_VIEW();
+
+    int x = get_global_id(0),
+	y = get_global_id(1),
+	k = state[x + y * width];
+
+    if (k < 0)			// not an edge, or converged
+	return;
+
+    int4   s     = sum[x + y * width];
+    uchar4 pixel = pixmap_get_pixel(pixmap, x, y, width);
+    int    n     = max(MIN_SAMPLES, 0x01 << (32 - clz(k)));	// end of the current doubling
+    double d     = 2.0 * radius / min(width, height);
+    c_r += d * (x - width  / 2),
+    c_i += d * (height / 2 - y);
+
+    for (int b = 0; b < budget; b += VLEN) {	// pixel refinement with MC integration
+	doubleV p_r = c_r + d * vloadV(k / VLEN, dx),
+		p_i = c_i - d * vloadV(k / VLEN, dy);
+	intV   iter = mandelbrot(iter_max, p_r, p_i);
+	s += colormap_sum(colormap, iter % iter_max);
+	if ((k += VLEN) == n) {	// end of the doubling
+	    uchar4 average = convert_uchar4_sat((s + (n >> 1)) / n);
+	    bool   done    = equivalent_color(average, pixel) || (n << 0x01) > MAX_SAMPLES;
+	    pixel = average;
+	    if (done) {
+		k = -1;
+		break;
 	    }
-	    sum    += sum4.s0123 + sum4.s4567 + sum4.s89ab + sum4.scdef;
-	    pixel   = average;
-	    average = convert_uchar4_sat((sum + (n >> 1)) / n);
-	} while (!equivalent_color(average, pixel) &&
-			(n = (m = n) << 0x01) <= MAX_SAMPLES);
-	pixel = average;
+	    n <<= 0x01;
+	}
     }
 
+    sum  [x + y * width] = s;
+    state[x + y * width] = k;
+
+    if (k >= 0)
+	atomic_inc(remain);
+
 #if        SIZEOF_PIXEL_T == 3
     vstore3(pixel.s123, x + y * width, pixmap);
 #else	// SIZEOF_PIXEL_T == 4
@@ -97,15 +492,15 @@ __kernel void antialiasing_GPU
 }
 
 //----------------------------------------------------------------------
-inline int4 mandelbrot(int iter_max, double4 p_r, double4 p_i)
+inline intV mandelbrot(int iter_max, doubleV p_r, doubleV p_i)
 {
-    int4    i, mask;
-    double4 z_r, z_i, work;
+    intV    i, mask;
+    doubleV z_r, z_i, work;
 
     work = 2.0 * p_r * p_i;
     z_r  = p_r * p_r;
     z_i  = p_i * p_i;
-    mask = convert_int4(isless(z_r + z_i, BAILOUT));	// (z_r + z_i < BAILOUT) ? -1 : 0;
+    mask = convert_intV(isless(z_r + z_i, BAILOUT));	// (z_r + z_i < BAILOUT) ? -1 : 0;
     i    = -mask;
 
     for (int k = 1; k < iter_max && any(mask); k++) {
@@ -114,13 +509,38 @@ inline int4 mandelbrot(int iter_max, double4 p_r, double4 p_i)
 	work = 2.0 * z_r * z_i;
 	z_r *= z_r;
 	z_i *= z_i;
-	mask = convert_int4(isless(z_r + z_i, BAILOUT));
+	mask = convert_intV(isless(z_r + z_i, BAILOUT));
 	i   -= mask;
     }
 
     return i;
 }
 
+//----------------------------------------------------------------------
+inline uchar4 refine_pixel(__global uchar *colormap, int iter_max, double c_r, double c_i, double radius,
+	int x, int y, int width, int height, __global double *dx, __global double *dy, uchar4 pixel)
+{				// over-sampling for an edge pixel, VLEN samples at a time.
+    uchar4 average  = pixel;
+    int4   sum      = 0;
+    int    m = 0, n = MIN_SAMPLES;
+    double d = 2.0 * radius / min(width, height);
+    c_r += d * (x - width  / 2),
+    c_i += d * (height / 2 - y);
+    do {
+	for (int k = m; k < n; k += VLEN) {
+	    doubleV p_r = c_r + d * vloadV(k / VLEN, dx),
+		    p_i = c_i - d * vloadV(k / VLEN, dy);
+	    intV   iter = mandelbrot(iter_max, p_r, p_i);
+	    sum += colormap_sum(colormap, iter % iter_max);
+	}
+	pixel   = average;
+	average = convert_uchar4_sat((sum + (n >> 1)) / n);
+    } while (!equivalent_color(average, pixel) &&
+		    (n = (m = n) << 0x01) <= MAX_SAMPLES);
+
+    return average;
+}
+
 //----------------------------------------------------------------------
 inline bool detect_edge(__global uchar *pixmap, uchar4 *pixel, int x, int y, int width, int height)
 #if 1
@@ -155,6 +575,22 @@ inline bool detect_edge(__global uchar *pixmap, uchar4 *pixel, int x, int y, int
 }
 #endif
 
+//----------------------------------------------------------------------
+inline bool detect_edge_tile(__local uchar4 *tile, uchar4 *pixel, int x, int y)
+{				// (x,y) in the tile with halo
+    *pixel = tile[x + y * HALO_W];
+
+    for (int j = y - 1; j <= y + 1; j++)
+	for (int i = x - 1; i <= x + 1; i++)
+	    if (i != x || j != y) {
+		uchar4 p = tile[i + j * HALO_W];
+		if (!equivalent_color(*pixel, p))
+		    return true;
+	    }
+
+    return false;
+}
+
 //----------------------------------------------------------------------
 inline bool equivalent_color(uchar4 p, uchar4 q)
 #ifdef USE_SAME_COLOR
@@ -190,19 +626,14 @@ inline uchar4 pixmap_get_pixel(__global uchar *pixmap, int x, int y, int stride)
 #endif
 
 //----------------------------------------------------------------------
-inline uchar16 colormap_lookup(__global uchar *colormap, int4 index)
-#if        SIZEOF_PIXEL_T == 3
-{
-    return (uchar16) ((uchar) 0x00, vload3(index.s0, colormap),
-		      (uchar) 0x00, vload3(index.s1, colormap),
-		      (uchar) 0x00, vload3(index.s2, colormap),
-		      (uchar) 0x00, vload3(index.s3, colormap));
-}
-#else	// SIZEOF_PIXEL_T == 4 .........................................
-{
-    return (uchar16) (vload4(index.s0, colormap),
-		      vload4(index.s1, colormap),
-		      vload4(index.s2, colormap),
-		      vload4(index.s3, colormap));
+inline int4 colormap_sum(__global uchar *colormap, intV index)
+{				// sum of colors of VLEN indices
+    int  i[VLEN];
+    int4 sum = 0;
+
+    vstoreV(index, 0, i);
+    for (int j = 0; j < VLEN; j++)
+	sum += convert_int4(pixmap_get_pixel(colormap, i[j], 0, 0));
+
+    return sum;
 }
-#endif
@@ -35,6 +35,9 @@ typedef double real_t;
 #define MAX_SAMPLING	(0x01<<16)
 #define MAX_ITER	(0x01<<16)
 
+// head pixel of the row block owned by rank r out of p ranks
+#define BLOCK_HEAD(r,p)	((size_t) WIDTH * (HEIGHT * (r) / (p)))
+
 // prototypes
 void init_colormap  (uint8_t *);
 void init_jitter    (float   *, float   *);
@@ -46,6 +49,7 @@ bool same_color     (uint8_t  , uint8_t  , uint8_t  , uint8_t  , uint8_t, uint8_
 inline
 int  mandelbrot     (real_t   , real_t  );
 void write_out_image(uint8_t *, const char *);
+void gather_blocks  (uint8_t *, bool, int, int);
 
 //======================================================================
 int main(int argc, char **argv)
@@ -66,7 +70,7 @@ int main(int argc, char **argv)
 	image    = new uint8_t[3 * WIDTH * HEIGHT      ];
 	dx       = new float  [MAX_SAMPLING            ];
 	dy       = new float  [MAX_SAMPLING            ];
-    } catch (std::bad_alloc e) {
+    } catch (const std::bad_alloc &e) {
 	std::cerr << e.what() << std::endl;
 	return EXIT_FAILURE;
     }
@@ -146,7 +150,7 @@ void draw_image(uint8_t *image, uint8_t *sketch, uint8_t *colormap,
     rough_sketch(sketch, colormap, nprocs, myrank);
 
 #pragma omp parallel for schedule(dynamic,1)
-    for (size_t l = myrank; l < WIDTH * HEIGHT; l += nprocs) {
+    for (size_t l = BLOCK_HEAD(myrank, nprocs); l < BLOCK_HEAD(myrank + 1, nprocs); l++) {
 	int i = l % WIDTH,
 	    j = l / WIDTH;
 	uint8_t r , g , b ,
@@ -178,10 +182,7 @@ void draw_image(uint8_t *image, uint8_t *sketch, uint8_t *colormap,
 	image[3 * l + 2] = b;
     }
 
-#ifdef USE_MPI
-    MPI_Allreduce(MPI_IN_PLACE, image, 3 * WIDTH * HEIGHT * sizeof(uint8_t),
-		  MPI_BYTE, MPI_BOR, MPI_COMM_WORLD);
-#endif
+    gather_blocks(image , false, nprocs, myrank);	// only to the writer
 
     return;
 }
@@ -190,7 +191,7 @@ void draw_image(uint8_t *image, uint8_t *sketch, uint8_t *colormap,
 void rough_sketch(uint8_t *sketch, uint8_t *colormap, int nprocs, int myrank)
 {				// draw rough sketch image.
 #pragma omp parallel for schedule(dynamic,1)
-    for (size_t k = myrank; k < WIDTH * HEIGHT; k += nprocs) {
+    for (size_t k = BLOCK_HEAD(myrank, nprocs); k < BLOCK_HEAD(myrank + 1, nprocs); k++) {
 	int i = k % WIDTH,
 	    j = k / WIDTH;
 	real_t p_r = C_R + D * (i - WIDTH  / 2),
@@ -204,9 +205,40 @@ void rough_sketch(uint8_t *sketch, uint8_t *colormap, int nprocs, int myrank)
 	sketch[3 * k + 2] = b;
     }
 
+    gather_blocks(sketch, true , nprocs, myrank);	// to all ranks
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void gather_blocks(uint8_t *image, bool all, int nprocs, int myrank)
+{				// gather row blocks of image to rank 0 (or all ranks).
 #ifdef USE_MPI
-    MPI_Allreduce(MPI_IN_PLACE, sketch, 3 * WIDTH * HEIGHT * sizeof(uint8_t),
-		  MPI_BYTE, MPI_BOR, MPI_COMM_WORLD);
+    int *count = nullptr, *displ = nullptr;
+
+    try {
+	count = new int[nprocs];
+	displ = new int[nprocs];
+    } catch (const std::bad_alloc &e) {
+	std::cerr << e.what() << std::endl;
+	MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    for (int p = 0; p < nprocs; p++) {
+	count[p] = 3 * (BLOCK_HEAD(p + 1, nprocs) - BLOCK_HEAD(p, nprocs));
+	displ[p] = 3 *  BLOCK_HEAD(p    , nprocs);
+    }
+
+    if (all)
+	MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+		       image, count, displ, MPI_BYTE, MPI_COMM_WORLD);
+    else
+	MPI_Gatherv((myrank == 0) ? MPI_IN_PLACE : image + displ[myrank],
+		    count[myrank], MPI_BYTE,
+		    image, count, displ, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    delete[] displ;
+    delete[] count;
 #endif
 
     return;
@@ -0,0 +1,92 @@
+/*
+ * affinity.c: thread binding and memory placement query
+ * (c)2026 Seiji Nishimura
+ * $Id: affinity.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include "affinity_internal.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <stdint.h>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#define PAGES_PER_QUERY	1024
+
+//======================================================================
+int affinity_bind_threads(void)
+{				// bind i-th OpenMP thread to i-th CPU in the affinity
+				// mask of this process (MPI launcher may restrict it).
+				// return 0 on success, otherwise -1.
+#if defined(__linux__) && defined(CPU_SET)
+    cpu_set_t mask;
+    int cpus[CPU_SETSIZE], ncpus = 0, err = 0;
+
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &mask) == -1)
+	return -1;
+
+    for (int i = 0; i < CPU_SETSIZE; i++)
+	if (CPU_ISSET(i, &mask))
+	    cpus[ncpus++] = i;
+
+#pragma omp parallel reduction(|:err)
+    {
+	cpu_set_t bind;
+	int tid = 0;
+#ifdef _OPENMP
+	tid = omp_get_thread_num();
+#endif
+	CPU_ZERO(&bind);
+	CPU_SET (cpus[tid % ncpus], &bind);
+	if (sched_setaffinity(0, sizeof(cpu_set_t), &bind) == -1)
+	    err = 1;
+    }
+
+    return err ? -1 : 0;
+#else
+    return -1;
+#endif
+}
+
+//----------------------------------------------------------------------
+int affinity_query_nodes(const void *addr, size_t len, long *npages)
+{				// count resident pages of [addr:addr+len) on each
+				// NUMA node, npages[AFFINITY_MAX_NODES] is filled.
+				// return # of nodes (max. node ID + 1), or -1 on error.
+#if defined(__linux__) && defined(SYS_move_pages)
+    long      page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t head = (uintptr_t) addr & ~(uintptr_t) (page_size - 1),
+	      tail = (uintptr_t) addr + len;
+    void *pages [PAGES_PER_QUERY];
+    int   status[PAGES_PER_QUERY], nnodes = 0;
+
+    for (int i = 0; i < AFFINITY_MAX_NODES; i++)
+	npages[i] = 0;
+
+    while (head < tail) {
+	int n = 0;
+	while (n < PAGES_PER_QUERY && head < tail) {
+	    pages[n++] = (void *) head;
+	    head      += page_size;
+	}
+	// move_pages(2) with NULL nodes only queries the node of pages.
+	if (syscall(SYS_move_pages, 0, n, pages, NULL, status, 0) == -1)
+	    return -1;
+	for (int i = 0; i < n; i++)
+	    if (status[i] >= 0 && status[i] < AFFINITY_MAX_NODES) {
+		npages[status[i]]++;
+		if (nnodes < status[i] + 1)
+		    nnodes = status[i] + 1;
+	    }
+    }
+
+    return nnodes;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,33 @@
+/*
+ * affinity.h: thread binding and memory placement query
+ * (c)2026 Seiji Nishimura
+ * $Id: affinity.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __AFFINITY_H__
+#define __AFFINITY_H__
+
+#include <stddef.h>
+
+#ifdef  __AFFINITY_INTERNAL__
+#define   AFFINITY_API
+#else
+#define   AFFINITY_API	extern
+#endif
+
+#define AFFINITY_MAX_NODES	64
+
+/* prototypes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+AFFINITY_API int affinity_bind_threads(void);
+AFFINITY_API int affinity_query_nodes (const void *, size_t, long *);
+
+#ifdef __cplusplus
+}
+#endif
+#undef    AFFINITY_API
+#endif
@@ -0,0 +1,16 @@
+/*
+ * affinity_internal.h: thread binding and memory placement query
+ * (c)2026 Seiji Nishimura
+ * $Id: affinity_internal.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __AFFINITY_INTERNAL__
+#define __AFFINITY_INTERNAL__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		// for sched_setaffinity(2) and syscall(2)
+#endif
+
+#include "affinity.h"
+
+#endif
@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #ifdef CL_UTIL_USE_STAT
@@ -15,33 +16,123 @@
 #include <sys/stat.h>
 #endif
 
+#ifndef CL_UTIL_NO_CACHE
+#include <unistd.h>
+#endif
+
 typedef enum { BINARY, SOURCE } kernel_type_t;
 
 #define N_TBL		(0x01<<8)
 
+#ifdef CL_UTIL_PROFILE
+#define N_PROF		(0x01<<6)	// kinds of commands
+#define N_EVENTS	(0x01<<10)	// events not resolved yet
+
+typedef struct {		// profile of a kind of commands on a device
+    cl_device_id device;
+    char   name[64];
+    long   count;
+    double time;		// [sec.]
+    size_t bytes;		// of transfers
+} cl_prof_t;
+
+static struct {
+    int       num_profs, num_events;
+    cl_prof_t prof [N_PROF  ];
+    cl_event  event[N_EVENTS];
+    int       index[N_EVENTS];	// of prof[] for event[]
+} clProfile_;
+#endif
+
 #define size(tbl)	(sizeof(tbl)/sizeof(tbl[0]))
 
 // prototypes
 static cl_device_id  clFindTargetDevice_(const char *, cl_device_type, cl_uint     );
+static cl_uint       clFindDevices_     (const char *, cl_device_type, cl_device_id *, cl_uint);
+static void          clOpenDevice_      (cl_obj_t   *, cl_device_id  , const char *, const char *);
 static cl_program    clCompileKernel_   (cl_obj_t   *, const char   *, const char *);
 static char         *clLoadKernelSrc_   (const char *, size_t       *);
 static kernel_type_t clDetectKernelType_(const char *);
 static void          clCheckStatus_     (const char *, cl_int        );
+static cl_bool       clHostBacked_      (cl_mem      );
+static void         *clMapBuffer_       (cl_command_queue, cl_mem, cl_map_flags, size_t, size_t);
+#ifndef CL_UTIL_NO_CACHE
+static char         *clCachePath_       (cl_obj_t   *, const char   *, const char *, size_t, const char *);
+static cl_program    clLoadCache_       (cl_obj_t   *, const char   *, const char *);
+static void          clSaveCache_       (cl_program  , const char   *);
+static uint64_t      clHash_            (uint64_t    , const void   *, size_t      );
+#endif
+#ifdef CL_UTIL_PROFILE
+static void          clProfRecord_      (cl_command_queue, const char *, size_t, cl_event, cl_event *);
+static void          clProfResolve_     (void);
+static void          clProfReport_      (cl_obj_t   *);
+#endif
 
 //----------------------------------------------------------------------
 void cl_init
 	(cl_obj_t *obj, char *platform_name, cl_device_type device_type, cl_uint device_num,
 	 char  *kernel, char *build_options)
 {				// initialize OpenCL.
+    // find the target OpenCL device.
+    clOpenDevice_(obj, clFindTargetDevice_(platform_name, device_type, device_num),
+			kernel, build_options);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+int cl_init_devices
+	(cl_obj_t *obj, int max_devices, char *platform_name, cl_device_type device_type,
+	 cl_uint sub_units, char *kernel, char *build_options)
+{				// initialize OpenCL on all devices of the type up to max_devices,
+				// and return the number of them. each device is partitioned into
+				// sub-devices of sub_units compute units unless sub_units is 0.
+    cl_device_id dev_id[N_TBL];
+    cl_uint      num_devices;
+    int          count = 0;
+
+    num_devices = clFindDevices_(platform_name, device_type, dev_id, size(dev_id));
+
+    if (num_devices == 0)	// could not find any appropriate device.
+	cl_check_status(CL_DEVICE_NOT_FOUND);
+
+    for (int i = 0; i < num_devices && count < max_devices; i++) {
+	cl_device_id sub_id[N_TBL];
+	cl_uint      num_subs = 0;
+	if (sub_units > 0) {	// fall back to the root device if it cannot be partitioned.
+	    cl_device_partition_property props[] = { CL_DEVICE_PARTITION_EQUALLY, sub_units, 0 };
+	    if (clCreateSubDevices(dev_id[i], props, size(sub_id), sub_id, &num_subs) != CL_SUCCESS)
+		num_subs = 0;
+	}
+	if (num_subs == 0)
+	    clOpenDevice_(&obj[count++], dev_id[i], kernel, build_options);
+	for (int j = 0; j < num_subs; j++)
+	    if (count < max_devices)
+		clOpenDevice_(&obj[count++], sub_id[j], kernel, build_options);
+	    else
+		clReleaseDevice(sub_id[j]);
+    }
+
+    return count;
+}
+
+//----------------------------------------------------------------------
+static
+void clOpenDevice_
+	(cl_obj_t *obj, cl_device_id device, const char *kernel, const char *build_options)
+{				// create context, queue and program on the device.
     cl_int status;
 
-    // find the target OpenCL device.
-    obj->device  = clFindTargetDevice_(platform_name, device_type, device_num);
+    obj->device  = device;
 
     obj->context = clCreateContext(NULL, 1, &obj->device, NULL, NULL, &status);
     cl_check_status(status);
 
+#ifdef CL_UTIL_PROFILE
+    obj->queue   = clCreateCommandQueue(obj->context, obj->device, CL_QUEUE_PROFILING_ENABLE, &status);
+#else
     obj->queue   = clCreateCommandQueue(obj->context, obj->device, 0, &status);
+#endif
     cl_check_status(status);
 
     // OpenCL kernel JIT compilation
@@ -54,9 +145,134 @@ void cl_init
 void cl_fin
 	(cl_obj_t *obj)
 {				// finalize OpenCL.
+#ifdef CL_UTIL_PROFILE
+    clProfReport_(obj);
+#endif
     clReleaseProgram     (obj->program);
     clReleaseCommandQueue(obj->queue  );
     clReleaseContext     (obj->context);
+    clReleaseDevice      (obj->device );	// no-op for root devices
+
+    return;
+}
+
+//----------------------------------------------------------------------
+cl_uint cl_num_devices
+	(char *platform_name, cl_device_type device_type)
+{				// count OpenCL devices of the type, which are numbered
+				// from 0 as device_num of cl_init() in the same order.
+    cl_platform_id platform[N_TBL];
+    cl_device_id   dev_id  [N_TBL];
+    cl_uint num_devices, num_platforms, count = 0;
+    cl_int  status;
+
+    status = clGetPlatformIDs(size(platform), platform, &num_platforms);
+    cl_check_status(status);
+
+    for (int i = 0; i < num_platforms; i++) {	// search all platforms.
+	char pname[256];
+	status = clGetPlatformInfo(platform[i], CL_PLATFORM_NAME, sizeof(pname), pname, NULL);
+	cl_check_status(status);
+	if (platform_name != NULL)	// platform_name is given, but current platform does not match.
+	    if (strcasecmp(platform_name, pname) != 0)
+		continue;
+	status = clGetDeviceIDs(platform[i], device_type, size(dev_id), dev_id, &num_devices);
+	if (status == CL_DEVICE_NOT_FOUND)
+	    continue;
+	cl_check_status(status);
+	count += num_devices;
+    }
+
+    return count;
+}
+
+//----------------------------------------------------------------------
+cl_uint cl_native_vector_width
+	(char *platform_name, cl_device_type device_type, cl_uint device_num)
+{				// native vector width of double on the device of cl_init(),
+				// which is 0 if double precision is not supported.
+    cl_uint width;
+    cl_int  status;
+
+    status = clGetDeviceInfo(clFindTargetDevice_(platform_name, device_type, device_num),
+			CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE, sizeof(cl_uint), &width, NULL);
+    cl_check_status(status);
+
+    return width;
+}
+
+//----------------------------------------------------------------------
+cl_mem cl_host_buffer
+	(cl_obj_t *obj, cl_mem_flags flags, size_t size, void *host_ptr)
+{				// create a buffer for host data. if the device shares memory with
+				// the host (e.g. a CPU device), the host data is used in place.
+    cl_mem buffer;
+    cl_int status;
+
+#ifndef CL_UTIL_NO_ZERO_COPY
+    cl_bool unified = CL_FALSE;
+
+    if (host_ptr != NULL)
+	clGetDeviceInfo(cl_query_device(obj), CL_DEVICE_HOST_UNIFIED_MEMORY,
+			sizeof(cl_bool), &unified, NULL);
+    if (unified)
+	flags |= CL_MEM_USE_HOST_PTR;
+    else
+#endif
+	host_ptr = NULL;
+
+    buffer = clCreateBuffer(cl_query_context(obj), flags, size, host_ptr, &status);
+    cl_check_status(status);
+
+    return buffer;
+}
+
+//----------------------------------------------------------------------
+void cl_write_buffer
+	(cl_obj_t *obj, cl_mem buffer, size_t offset, size_t size, const void *host_ptr)
+{				// blocking copy of host data to the buffer. a buffer on the
+				// host data is just mapped and unmapped, to be synchronized.
+    cl_command_queue queue = cl_query_queue(obj);
+    cl_int           status;
+
+    if (clHostBacked_(buffer)) {
+	void *ptr = clMapBuffer_(queue, buffer, CL_MAP_WRITE, offset, size);
+	if (ptr != host_ptr)	// not the host data of the buffer
+	    memcpy(ptr, host_ptr, size);
+	status = clEnqueueUnmapMemObject(queue, buffer, ptr, 0, NULL, NULL);
+    } else
+#ifdef CL_UTIL_PROFILE
+	status = cl_profile_write_(queue, buffer, CL_TRUE, offset, size, host_ptr, 0, NULL, NULL);
+#else
+	status = clEnqueueWriteBuffer(queue, buffer, CL_TRUE, offset, size, host_ptr, 0, NULL, NULL);
+#endif
+    cl_check_status(status);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void cl_read_buffer
+	(cl_obj_t *obj, cl_mem buffer, size_t offset, size_t size, void *host_ptr)
+{				// blocking copy of the buffer to host data. a buffer on the
+				// host data is just mapped and unmapped, to be synchronized.
+    cl_command_queue queue = cl_query_queue(obj);
+    cl_int           status;
+
+    if (clHostBacked_(buffer)) {
+	void *ptr = clMapBuffer_(queue, buffer, CL_MAP_READ, offset, size);
+	if (ptr != host_ptr)	// not the host data of the buffer
+	    memcpy(host_ptr, ptr, size);
+	status = clEnqueueUnmapMemObject(queue, buffer, ptr, 0, NULL, NULL);
+	if (status == CL_SUCCESS)	// host data is accessed after the unmap.
+	    status = clFinish(queue);
+    } else
+#ifdef CL_UTIL_PROFILE
+	status = cl_profile_read_(queue, buffer, CL_TRUE, offset, size, host_ptr, 0, NULL, NULL);
+#else
+	status = clEnqueueReadBuffer(queue, buffer, CL_TRUE, offset, size, host_ptr, 0, NULL, NULL);
+#endif
+    cl_check_status(status);
 
     return;
 }
@@ -82,6 +298,58 @@ void cl_check_status_
 }
 #endif
 
+#ifdef CL_UTIL_PROFILE
+//----------------------------------------------------------------------
+cl_int cl_profile_write_
+	(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+	 const void *ptr, cl_uint num_events, const cl_event *wait_list, cl_event *event)
+{				// clEnqueueWriteBuffer() with profiling
+    cl_event ev;
+    cl_int   status = clEnqueueWriteBuffer(queue, buffer, blocking, offset, size, ptr,
+						num_events, wait_list, &ev);
+
+    if (status == CL_SUCCESS)
+	clProfRecord_(queue, "Write(H->D)", size, ev, event);
+
+    return status;
+}
+
+//----------------------------------------------------------------------
+cl_int cl_profile_read_
+	(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size,
+	 void *ptr, cl_uint num_events, const cl_event *wait_list, cl_event *event)
+{				// clEnqueueReadBuffer() with profiling
+    cl_event ev;
+    cl_int   status = clEnqueueReadBuffer(queue, buffer, blocking, offset, size, ptr,
+						num_events, wait_list, &ev);
+
+    if (status == CL_SUCCESS)
+	clProfRecord_(queue, "Read(D->H)", size, ev, event);
+
+    return status;
+}
+
+//----------------------------------------------------------------------
+cl_int cl_profile_kernel_
+	(cl_command_queue queue, cl_kernel kernel, cl_uint work_dim, const size_t *global_offset,
+	 const size_t *global_size, const size_t *local_size,
+	 cl_uint num_events, const cl_event *wait_list, cl_event *event)
+{				// clEnqueueNDRangeKernel() with profiling
+    cl_event ev;
+    cl_int   status = clEnqueueNDRangeKernel(queue, kernel, work_dim, global_offset, global_size,
+						local_size, num_events, wait_list, &ev);
+
+    if (status == CL_SUCCESS) {
+	char name[64];
+	if (clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, sizeof(name), name, NULL) != CL_SUCCESS)
+	    strcpy(name, "(unknown kernel)");
+	clProfRecord_(queue, name, 0, ev, event);
+    }
+
+    return status;
+}
+#endif
+
 //----------------------------------------------------------------------
 static
 cl_device_id clFindTargetDevice_
@@ -131,6 +399,35 @@ cl_device_id clFindTargetDevice_
     return device;
 }
 
+//----------------------------------------------------------------------
+static
+cl_uint clFindDevices_
+	(const char *platform_name, cl_device_type device_type, cl_device_id *device, cl_uint max_devices)
+{				// find all OpenCL devices of the type, in the order of device_num.
+    cl_platform_id platform[N_TBL];
+    cl_uint num_devices, num_platforms, count = 0;
+    cl_int  status;
+
+    status = clGetPlatformIDs(size(platform), platform, &num_platforms);
+    cl_check_status(status);
+
+    for (int i = 0; i < num_platforms && count < max_devices; i++) {	// search all platforms.
+	char pname[256];
+	status = clGetPlatformInfo(platform[i], CL_PLATFORM_NAME, sizeof(pname), pname, NULL);
+	cl_check_status(status);
+	if (platform_name != NULL)	// platform_name is given, but current platform does not match.
+	    if (strcasecmp(platform_name, pname) != 0)
+		continue;
+	status = clGetDeviceIDs(platform[i], device_type, max_devices - count, &device[count], &num_devices);
+	if (status == CL_DEVICE_NOT_FOUND)
+	    continue;
+	cl_check_status(status);
+	count += (num_devices < max_devices - count) ? num_devices : max_devices - count;
+    }
+
+    return count;
+}
+
 //----------------------------------------------------------------------
 static
 cl_program clCompileKernel_
@@ -150,24 +447,170 @@ cl_program clCompileKernel_
 	exit(EXIT_FAILURE);
 
     if (clDetectKernelType_(kernel) == SOURCE) {
+#ifndef CL_UTIL_NO_CACHE	// a cached binary of the same source, options and device
+	char *cache = clCachePath_(obj, kernel, kernel_src, kernel_size, build_options);
+	if ((program = clLoadCache_(obj, cache, build_options)) != NULL) {
+	    free(cache);
+	    free(kernel_src);
+	    return program;
+	}
+#endif
 	program = clCreateProgramWithSource
 			(context, 1, (const char **) &kernel_src, &kernel_size, &status);
 	cl_check_status(status);
+	status  = clBuildProgram(program, 1, &device, build_options, NULL, NULL);
+	cl_check_status(status);
+#ifndef CL_UTIL_NO_CACHE
+	clSaveCache_(program, cache);
+	free(cache);
+#endif
     } else {	// clDetectKernelType_(kernel) == BINARY
 	program = clCreateProgramWithBinary
 			(context, 1, &device,
 			   &kernel_size, (const unsigned char **) &kernel_src, NULL, &status);
 	cl_check_status(status);
+	status  = clBuildProgram(program, 1, &device, build_options, NULL, NULL);
+	cl_check_status(status);
     }
 
-    status = clBuildProgram(program, 1, &device, build_options, NULL, NULL);
-    cl_check_status(status);
-
     free(kernel_src);
 
     return program;
 }
 
+#ifndef CL_UTIL_NO_CACHE
+//----------------------------------------------------------------------
+static
+char *clCachePath_
+	(cl_obj_t *obj, const char *kernel, const char *kernel_src, size_t kernel_size, const char *build_options)
+{				// path name of the cached program binary: "<kernel>.<key>.bin",
+				// where the key is a hash of device, driver, source and options.
+    cl_device_info info[] = { CL_DEVICE_NAME, CL_DEVICE_VERSION, CL_DRIVER_VERSION };
+    uint64_t key = clHash_(0, NULL, 0);
+    size_t   length = strlen(kernel) + 2 * sizeof(key) + 6;
+    char    *path;
+
+    for (int i = 0; i < size(info); i++) {
+	char   buf[256];
+	size_t len;
+	cl_check_status(clGetDeviceInfo(cl_query_device(obj), info[i], sizeof(buf), buf, &len));
+	key = clHash_(key, buf, len);
+    }
+    key = clHash_(key, kernel_src, kernel_size);
+    if (build_options != NULL)
+	key = clHash_(key, build_options, strlen(build_options));
+
+    if ((path = (char *) malloc(length * sizeof(char))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+    snprintf(path, length, "%s.%016llx.bin", kernel, (unsigned long long) key);
+
+    return path;
+}
+
+//----------------------------------------------------------------------
+static
+cl_program clLoadCache_
+	(cl_obj_t *obj, const char *cache, const char *build_options)
+{				// build the program from the cached binary, or NULL.
+    cl_device_id device = cl_query_device(obj);
+    cl_program   program;
+    cl_int       status, binary_status;
+    size_t       binary_size;
+    char        *binary;
+    FILE        *fp;
+
+    if ((fp = fopen(cache, "rb")) == NULL)
+	return NULL;	// not cached yet
+
+    fseek(fp, 0, SEEK_END);
+    binary_size = ftell(fp);
+    rewind(fp);
+
+    if ((binary = (char *) malloc(binary_size * sizeof(char))) == NULL ||
+	binary_size != fread(binary, sizeof(char), binary_size, fp)) {
+	free  (binary);
+	fclose(fp);
+	return NULL;
+    }
+
+    fclose(fp);
+
+    program = clCreateProgramWithBinary
+			(cl_query_context(obj), 1, &device,
+			   &binary_size, (const unsigned char **) &binary, &binary_status, &status);
+    free(binary);
+
+    if (status != CL_SUCCESS)
+	return NULL;	// the binary is rejected by the driver.
+    if (binary_status != CL_SUCCESS) {
+	clReleaseProgram(program);
+	return NULL;
+    }
+
+    if (clBuildProgram(program, 1, &device, build_options, NULL, NULL) != CL_SUCCESS) {
+	clReleaseProgram(program);
+	return NULL;
+    }
+
+#ifdef CL_UTIL_DEBUG
+    printf("  Program : %s\n", cache);
+#endif
+
+    return program;
+}
+
+//----------------------------------------------------------------------
+static
+void clSaveCache_
+	(cl_program program, const char *cache)
+{				// save the program binary for later runs, but silently give up
+				// on any error. a temporary file is renamed for concurrent runs.
+    size_t binary_size;
+    char  *binary, temp[FILENAME_MAX];
+    FILE  *fp;
+
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES,
+			sizeof(size_t), &binary_size, NULL) != CL_SUCCESS || binary_size == 0)
+	return;
+
+    if ((binary = (char *) malloc(binary_size * sizeof(char))) == NULL)
+	return;
+
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARIES,
+			sizeof(char *), &binary, NULL) == CL_SUCCESS) {
+	snprintf(temp, sizeof(temp), "%s.%ld", cache, (long) getpid());
+	if ((fp = fopen(temp, "wb")) != NULL) {
+	    size_t n = fwrite(binary, sizeof(char), binary_size, fp);
+	    if (fclose(fp) != 0 || n != binary_size || rename(temp, cache) != 0)
+		remove(temp);
+	}
+    }
+
+    free(binary);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+static
+uint64_t clHash_
+	(uint64_t hash, const void *data, size_t length)
+{				// 64-bit FNV-1a hash, initialized with (0, NULL, 0).
+    const unsigned char *p = (const unsigned char *) data;
+
+    if (data == NULL)
+	return 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; i++)
+	hash = (hash ^ p[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+#endif
+
 //----------------------------------------------------------------------
 static
 char *clLoadKernelSrc_
@@ -262,6 +705,173 @@ kernel_type_t clDetectKernelType_(const char *fname)
     return kernel_type;
 }
 
+#ifdef CL_UTIL_PROFILE
+//----------------------------------------------------------------------
+static
+void clProfRecord_
+	(cl_command_queue queue, const char *name, size_t bytes, cl_event event, cl_event *user_event)
+{				// record an event of the command on the device of the queue, which is
+				// resolved later. host threads driving devices may record concurrently.
+    cl_device_id device = NULL;
+
+    clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(cl_device_id), &device, NULL);
+
+#pragma omp critical (cl_util_profile)
+    {
+	int i;
+
+	for (i = 0; i < clProfile_.num_profs; i++)
+	    if (clProfile_.prof[i].device == device &&
+		strcmp(clProfile_.prof[i].name, name) == 0)
+		break;
+
+	if (i == clProfile_.num_profs) {	// a new kind of commands
+	    if (i == N_PROF)
+		i--;		// the last one collects the others.
+	    else
+		clProfile_.num_profs++;
+	    clProfile_.prof[i].device = device;
+	    snprintf(clProfile_.prof[i].name, sizeof(clProfile_.prof[i].name), "%s", name);
+	}
+
+	clProfile_.prof[i].count++;
+	clProfile_.prof[i].bytes += bytes;
+
+	if (user_event != NULL) {	// the user also holds the event.
+	    *user_event = event;
+	    clRetainEvent(event);
+	}
+
+	if (clProfile_.num_events == N_EVENTS)
+	    clProfResolve_();
+
+	clProfile_.event[clProfile_.num_events  ] = event;
+	clProfile_.index[clProfile_.num_events++] = i;
+    }
+
+    return;
+}
+
+//----------------------------------------------------------------------
+static
+void clProfResolve_(void)
+{				// wait for recorded events, and accumulate their times.
+    for (int k = 0; k < clProfile_.num_events; k++) {
+	cl_event event = clProfile_.event[k];
+	cl_ulong ts = 0, te = 0;
+
+	clWaitForEvents(1, &event);
+	clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &ts, NULL);
+	clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END  , sizeof(cl_ulong), &te, NULL);
+	clReleaseEvent(event);
+
+	clProfile_.prof[clProfile_.index[k]].time += 1.E-9 * (te - ts);
+    }
+
+    clProfile_.num_events = 0;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+static
+void clProfReport_
+	(cl_obj_t *obj)
+{				// print the breakdown per kernel and per transfer on the device,
+				// whose records are removed then. the others are kept for their
+				// own devices.
+    static int num_reports = 0;	// CSV is written by the 1st report, and appended by the others.
+    char   dname[256];
+    double tm_kernel = 0.0, tm_transfer = 0.0;
+
+    if (clGetDeviceInfo(cl_query_device(obj), CL_DEVICE_NAME, sizeof(dname), dname, NULL) != CL_SUCCESS)
+	strcpy(dname, "(unknown device)");
+
+#pragma omp critical (cl_util_profile)
+    {
+	int n = 0;
+
+	clProfResolve_();
+
+	printf("OpenCL profile on %s:\n", dname);
+	for (int i = 0; i < clProfile_.num_profs; i++) {
+	    cl_prof_t *p = &clProfile_.prof[i];
+	    if (p->device != cl_query_device(obj))
+		continue;
+	    if (p->bytes > 0) {	// transfer
+		printf("  %-24s=%10.6f[sec.], #calls=%6ld, %8.3f[GB/s]\n", p->name, p->time, p->count,
+		       (p->time > 0.0) ? 1.E-9 * p->bytes / p->time : 0.0);
+		tm_transfer += p->time;
+	    } else {
+		printf("  %-24s=%10.6f[sec.], #calls=%6ld\n", p->name, p->time, p->count);
+		tm_kernel   += p->time;
+	    }
+	}
+	printf("Kernel/Transfer=%.3f/%.3f[sec.]\n", tm_kernel, tm_transfer);
+
+#ifdef CL_UTIL_PROFILE_CSV
+	FILE *fp;
+	if ((fp = fopen(CL_UTIL_PROFILE_CSV, (num_reports == 0) ? "w" : "a")) == NULL)
+	    perror(CL_UTIL_PROFILE_CSV);
+	else {
+	    if (num_reports == 0)
+		fprintf(fp, "device,command,calls,time,bytes\n");
+	    for (int i = 0; i < clProfile_.num_profs; i++)
+		if (clProfile_.prof[i].device == cl_query_device(obj))
+		    fprintf(fp, "%d,%s,%ld,%.9f,%zu\n", num_reports,
+			    clProfile_.prof[i].name, clProfile_.prof[i].count,
+			    clProfile_.prof[i].time, clProfile_.prof[i].bytes);
+	    fclose(fp);
+	}
+#endif
+	num_reports++;
+
+	// records of the device are removed (no events are pending after resolved).
+	for (int i = 0; i < clProfile_.num_profs; i++)
+	    if (clProfile_.prof[i].device != cl_query_device(obj))
+		clProfile_.prof[n++] = clProfile_.prof[i];
+	clProfile_.num_profs = n;
+    }
+
+    return;
+}
+#endif
+
+//----------------------------------------------------------------------
+static
+cl_bool clHostBacked_
+	(cl_mem buffer)
+{				// is the buffer created on host data?
+    cl_mem_flags flags;
+    cl_int       status;
+
+    status = clGetMemObjectInfo(buffer, CL_MEM_FLAGS, sizeof(flags), &flags, NULL);
+    cl_check_status(status);
+
+    return (flags & CL_MEM_USE_HOST_PTR) ? CL_TRUE : CL_FALSE;
+}
+
+//----------------------------------------------------------------------
+static
+void *clMapBuffer_
+	(cl_command_queue queue, cl_mem buffer, cl_map_flags flags, size_t offset, size_t size)
+{				// blocking map of the region of buffer.
+    void  *ptr;
+    cl_int status;
+#ifdef CL_UTIL_PROFILE
+    cl_event ev;
+
+    ptr = clEnqueueMapBuffer(queue, buffer, CL_TRUE, flags, offset, size, 0, NULL, &ev, &status);
+    cl_check_status(status);
+    clProfRecord_(queue, "Map(zero-copy)", size, ev, NULL);
+#else
+    ptr = clEnqueueMapBuffer(queue, buffer, CL_TRUE, flags, offset, size, 0, NULL, NULL, &status);
+    cl_check_status(status);
+#endif
+
+    return ptr;
+}
+
 //----------------------------------------------------------------------
 static
 void clCheckStatus_
@@ -48,12 +48,34 @@ typedef struct {
 extern "C" {
 #endif
 
-CL_UTIL_API void cl_init         (cl_obj_t *, char *, cl_device_type, cl_uint, char *, char *);
-CL_UTIL_API void cl_fin          (cl_obj_t *);
-CL_UTIL_API void cl_check_status_(const char *, const int, cl_int);
+CL_UTIL_API void    cl_init         (cl_obj_t *, char *, cl_device_type, cl_uint, char *, char *);
+CL_UTIL_API int     cl_init_devices (cl_obj_t *, int, char *, cl_device_type, cl_uint, char *, char *);
+CL_UTIL_API void    cl_fin          (cl_obj_t *);
+CL_UTIL_API cl_uint cl_num_devices  (char *, cl_device_type);
+CL_UTIL_API cl_uint cl_native_vector_width(char *, cl_device_type, cl_uint);
+CL_UTIL_API cl_mem  cl_host_buffer  (cl_obj_t *, cl_mem_flags, size_t, void *);
+CL_UTIL_API void    cl_write_buffer (cl_obj_t *, cl_mem, size_t, size_t, const void *);
+CL_UTIL_API void    cl_read_buffer  (cl_obj_t *, cl_mem, size_t, size_t, void *);
+CL_UTIL_API void    cl_check_status_(const char *, const int, cl_int);
+#ifdef CL_UTIL_PROFILE
+CL_UTIL_API cl_int  cl_profile_write_ (cl_command_queue, cl_mem, cl_bool, size_t, size_t, const void *,
+					cl_uint, const cl_event *, cl_event *);
+CL_UTIL_API cl_int  cl_profile_read_  (cl_command_queue, cl_mem, cl_bool, size_t, size_t, void *,
+					cl_uint, const cl_event *, cl_event *);
+CL_UTIL_API cl_int  cl_profile_kernel_(cl_command_queue, cl_kernel, cl_uint, const size_t *, const size_t *,
+					const size_t *, cl_uint, const cl_event *, cl_event *);
+#endif
 
 #ifdef __cplusplus
 }
 #endif
+
+// event profiling: enqueued commands of user programs are timed with events,
+// and the breakdown per kernel and per transfer is printed by cl_fin().
+#if defined(CL_UTIL_PROFILE) && !defined(__CL_UTIL_INTERNAL__)
+#define clEnqueueWriteBuffer(q,m,b,o,s,p,n,l,e)		cl_profile_write_ (q,m,b,o,s,p,n,l,e)
+#define clEnqueueReadBuffer(q,m,b,o,s,p,n,l,e)		cl_profile_read_  (q,m,b,o,s,p,n,l,e)
+#define clEnqueueNDRangeKernel(q,k,d,o,g,l,n,w,e)	cl_profile_kernel_(q,k,d,o,g,l,n,w,e)
+#endif
 #undef CL_UTIL_API
 #endif
@@ -0,0 +1,338 @@
+/*
+ * lb_stat.c: load balance statistics of hybrid MPI+threads
+ * (c)2026 Seiji Nishimura
+ * $Id: lb_stat.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include "lb_stat_internal.h"
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <wtime.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(x,y)	(((x)>(y))?(x):(y))
+
+// # of doubles packed for a thread and a worst tile
+#define LB_THREAD_REC	(LB_NUM_KINDS + 1)	// time[*], num_tiles
+#define LB_TILE_REC	6			// time, x, y, width, height, thread
+
+// prototypes of internal procedures
+static int  lb_stat_thread_num_(void);
+static void lb_stat_insert_    (lb_tile_t *, lb_tile_t *);
+static void lb_stat_abort_     (const char *);
+
+//======================================================================
+void lb_stat_init(lb_stat_t *stat)
+{				// statistics for threads of the next parallel regions.
+    void *thread = NULL;
+
+#ifdef _OPENMP
+    stat->num_threads = omp_get_max_threads();
+#else
+    stat->num_threads = 1;
+#endif
+
+    if (posix_memalign(&thread, CACHE_LINE_SIZE,
+			stat->num_threads * sizeof(lb_thread_t)) != 0)
+	lb_stat_abort_(__func__);
+    stat->thread = (lb_thread_t *) thread;
+
+    lb_stat_reset(stat);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_fin(lb_stat_t *stat)
+{
+    free(stat->thread);
+
+    stat->thread      = NULL;
+    stat->num_threads = 0;
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_reset(lb_stat_t *stat)
+{
+    for (int t = 0; t < stat->num_threads; t++) {
+	lb_thread_t *thread = &stat->thread[t];
+	for (int k = 0; k < LB_NUM_KINDS; k++)
+	    thread->time[k] = 0.0;
+	for (int k = 0; k < LB_STAT_WORST; k++)
+	    thread->worst[k].time = -1.0;	// empty
+	thread->mark      = wtime(false);
+	thread->num_tiles = 0;
+    }
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_mark(lb_stat_t *stat)
+{				// begin an interval of the calling thread.
+    stat->thread[lb_stat_thread_num_()].mark = wtime(false);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+double lb_stat_lap(lb_stat_t *stat, lb_kind_t kind)
+{				// charge the interval of the calling thread to kind,
+				// and begin the next one.
+    lb_thread_t *thread = &stat->thread[lb_stat_thread_num_()];
+    double t = wtime(false), lap = t - thread->mark;
+
+    thread->time[kind] += lap;
+    thread->mark        = t;
+
+    return lap;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_tile(lb_stat_t *stat, tile_t *tile)
+{				// the interval was spent computing a tile.
+    int          t      = lb_stat_thread_num_();
+    lb_thread_t *thread = &stat->thread[t];
+    lb_tile_t    entry;
+
+    entry.time   = lb_stat_lap(stat, LB_COMPUTE);
+    entry.x      = tile->x;
+    entry.y      = tile->y;
+    entry.width  = tile->width ;
+    entry.height = tile->height;
+    entry.pe     = 0;		// filled in by lb_stat_report().
+    entry.thread = t;
+
+    thread->num_tiles++;
+    lb_stat_insert_(thread->worst, &entry);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_sync(lb_stat_t *stat)
+{				// collective, outside parallel regions: waiting for
+				// the slowest PE before communication is charged
+				// to the master thread.
+#ifdef USE_MPI
+    lb_stat_mark(stat);
+    MPI_Barrier(MPI_COMM_WORLD);
+    lb_stat_lap (stat, LB_WAIT);
+#endif
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void lb_stat_report(lb_stat_t *stat, const char *fname)
+{				// collective: report min/avg/max time of all threads of
+				// all PEs and the worst tiles on PE0, and write time of
+				// each thread into a CSV file unless fname is NULL.
+    int     nprocs = 1, myrank = 0, num_threads = 0,
+	   *nthreads = NULL, *count = NULL, *displ = NULL;
+    double *rec, *recs = NULL, *worst, *worsts = NULL;
+    lb_tile_t local[LB_STAT_WORST];
+
+#ifdef USE_MPI
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+#endif
+
+    if ((rec   = (double *) malloc(stat->num_threads * LB_THREAD_REC * sizeof(double))) == NULL ||
+	(worst = (double *) malloc(LB_STAT_WORST     * LB_TILE_REC   * sizeof(double))) == NULL)
+	lb_stat_abort_(__func__);
+
+    // pack time of threads, and the worst tiles of this PE.
+    for (int k = 0; k < LB_STAT_WORST; k++)
+	local[k].time = -1.0;
+
+    for (int t = 0; t < stat->num_threads; t++) {
+	lb_thread_t *thread = &stat->thread[t];
+	for (int k = 0; k < LB_NUM_KINDS; k++)
+	    rec[t * LB_THREAD_REC + k] = thread->time[k];
+	rec[t * LB_THREAD_REC + LB_NUM_KINDS] = (double) thread->num_tiles;
+	for (int k = 0; k < LB_STAT_WORST && thread->worst[k].time >= 0.0; k++)
+	    lb_stat_insert_(local, &thread->worst[k]);
+    }
+
+    for (int k = 0; k < LB_STAT_WORST; k++) {
+	double *w = &worst[k * LB_TILE_REC];
+	w[0] = local[k].time;
+	w[1] = local[k].x;
+	w[2] = local[k].y;
+	w[3] = local[k].width ;
+	w[4] = local[k].height;
+	w[5] = local[k].thread;
+    }
+
+    if (myrank == 0 &&
+	((nthreads = (int    *) malloc(nprocs * sizeof(int))) == NULL ||
+	 (count    = (int    *) malloc(nprocs * sizeof(int))) == NULL ||
+	 (displ    = (int    *) malloc(nprocs * sizeof(int))) == NULL ||
+	 (worsts   = (double *) malloc(nprocs * LB_STAT_WORST * LB_TILE_REC * sizeof(double))) == NULL))
+	lb_stat_abort_(__func__);
+
+#ifdef USE_MPI
+    MPI_Gather(&stat->num_threads, 1, MPI_INT, nthreads, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#else
+    nthreads[0] = stat->num_threads;
+#endif
+
+    if (myrank == 0) {
+	for (int p = 0; p < nprocs; p++) {
+	    count[p]     = nthreads[p] * LB_THREAD_REC;
+	    displ[p]     = num_threads * LB_THREAD_REC;
+	    num_threads += nthreads[p];
+	}
+	if ((recs = (double *) malloc(num_threads * LB_THREAD_REC * sizeof(double))) == NULL)
+	    lb_stat_abort_(__func__);
+    }
+
+#ifdef USE_MPI
+    MPI_Gatherv(rec, stat->num_threads * LB_THREAD_REC, MPI_DOUBLE,
+		recs, count, displ, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Gather (worst, LB_STAT_WORST * LB_TILE_REC, MPI_DOUBLE,
+		worsts,    LB_STAT_WORST * LB_TILE_REC, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#else
+    memcpy(recs  , rec  , stat->num_threads * LB_THREAD_REC * sizeof(double));
+    memcpy(worsts, worst, LB_STAT_WORST     * LB_TILE_REC   * sizeof(double));
+#endif
+
+    if (myrank == 0) {
+	static const char *name[LB_NUM_KINDS] = { "Compute", "Wait   ", "Comm   " };
+	double t_min[LB_NUM_KINDS], t_sum[LB_NUM_KINDS], t_max[LB_NUM_KINDS],
+	       pe_max = 0.0, pe_sum = 0.0;
+	int    p_max[LB_NUM_KINDS], q_max[LB_NUM_KINDS];
+	long   num_tiles = 0;
+
+	for (int k = 0; k < LB_NUM_KINDS; k++) {
+	    t_min[k] = recs[k];
+	    t_sum[k] = t_max[k] = 0.0;
+	    p_max[k] = q_max[k] = 0;
+	}
+
+	for (int p = 0, i = 0; p < nprocs; p++) {
+	    double pe_compute = 0.0;
+	    for (int t = 0; t < nthreads[p]; t++, i++) {
+		double *r = &recs[i * LB_THREAD_REC];
+		for (int k = 0; k < LB_NUM_KINDS; k++) {
+		    if (r[k] < t_min[k])
+			t_min[k] = r[k];
+		    if (r[k] > t_max[k]) {
+			t_max[k] = r[k];
+			p_max[k] = p;
+			q_max[k] = t;
+		    }
+		    t_sum[k] += r[k];
+		}
+		pe_compute += r[LB_COMPUTE];
+		num_tiles  += (long) r[LB_NUM_KINDS];
+	    }
+	    pe_max  = MAX(pe_max, pe_compute);
+	    pe_sum +=             pe_compute;
+	}
+
+	printf("Load balance: #PE=%d, #threads=%d, #tiles=%ld\n", nprocs, num_threads, num_tiles);
+	printf("          min[sec.]  avg[sec.]  max[sec.] (PE,thread of max)\n");
+	for (int k = 0; k < LB_NUM_KINDS; k++)
+	    printf("%s=%10.3f %10.3f %10.3f (PE%d,%d)\n", name[k],
+		   t_min[k], t_sum[k] / num_threads, t_max[k], p_max[k], q_max[k]);
+	if (pe_sum > 0.0)
+	    printf("Imbalance(compute)=%.3f(PE), %.3f(thread) (max/avg)\n",
+		   pe_max * nprocs / pe_sum, t_max[LB_COMPUTE] * num_threads / t_sum[LB_COMPUTE]);
+
+	// the worst tiles of all PEs
+	for (int k = 0; k < LB_STAT_WORST; k++)
+	    local[k].time = -1.0;
+	for (int i = 0; i < nprocs * LB_STAT_WORST; i++) {
+	    double   *w = &worsts[i * LB_TILE_REC];
+	    lb_tile_t entry;
+	    if (w[0] < 0.0)
+		continue;
+	    entry.time   =       w[0];
+	    entry.x      = (int) w[1];
+	    entry.y      = (int) w[2];
+	    entry.width  = (int) w[3];
+	    entry.height = (int) w[4];
+	    entry.thread = (int) w[5];
+	    entry.pe     = i / LB_STAT_WORST;
+	    lb_stat_insert_(local, &entry);
+	}
+	printf("Worst tiles:\n");
+	for (int k = 0; k < LB_STAT_WORST && local[k].time >= 0.0; k++)
+	    printf("  PE%-4d thread%-3d (x,y)=(%5d,%5d) %3dx%-3d: %10.6f[sec.]\n",
+		   local[k].pe, local[k].thread, local[k].x, local[k].y,
+		   local[k].width, local[k].height, local[k].time);
+
+	if (fname != NULL) {	// time of each thread
+	    FILE *fp;
+	    if ((fp = fopen(fname, "w")) == NULL)
+		perror(fname);
+	    else {
+		fprintf(fp, "pe,thread,tiles,compute,wait,comm\n");
+		for (int p = 0, i = 0; p < nprocs; p++)
+		    for (int t = 0; t < nthreads[p]; t++, i++) {
+			double *r = &recs[i * LB_THREAD_REC];
+			fprintf(fp, "%d,%d,%ld,%.6f,%.6f,%.6f\n", p, t, (long) r[LB_NUM_KINDS],
+				r[LB_COMPUTE], r[LB_WAIT], r[LB_COMM]);
+		    }
+		fclose(fp);
+	    }
+	}
+    }
+
+    free(recs    );
+    free(worsts  );
+    free(displ   );
+    free(count   );
+    free(nthreads);
+    free(worst   );
+    free(rec     );
+
+    return;
+}
+
+//----------------------------------------------------------------------
+static int lb_stat_thread_num_(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+//......................................................................
+static void lb_stat_insert_(lb_tile_t *worst, lb_tile_t *entry)
+{				// insert an entry into the worst tiles, if it is.
+    int k = LB_STAT_WORST;
+
+    if (entry->time <= worst[k - 1].time)
+	return;
+
+    while (--k > 0 && entry->time > worst[k - 1].time)
+	worst[k] = worst[k - 1];
+    worst[k] = *entry;
+
+    return;
+}
+
+//......................................................................
+static void lb_stat_abort_(const char *func)
+{
+    perror(func);
+#ifdef USE_MPI
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+#else
+    exit(EXIT_FAILURE);
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+ * lb_stat.h: load balance statistics of hybrid MPI+threads
+ * (c)2026 Seiji Nishimura
+ * $Id: lb_stat.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __LB_STAT_H__
+#define __LB_STAT_H__
+
+#include <tile_sched.h>
+
+#ifdef  __LB_STAT_INTERNAL__
+#define   LB_STAT_API
+#else
+#define   LB_STAT_API	extern
+#endif
+
+// # of worst (most time-consuming) tiles kept by a thread.
+#define LB_STAT_WORST	4
+
+typedef enum {			// time of a thread is classified into
+    LB_COMPUTE,			// computation of tiles
+    LB_WAIT,			// waiting for other threads and PEs
+    LB_COMM,			// tile fetching and MPI communication
+    LB_NUM_KINDS
+} lb_kind_t;
+
+typedef struct {		// tile and its computation time
+    double time;
+    int    x, y, width, height;
+    int    pe, thread;		// owner
+} lb_tile_t;
+
+typedef struct {		// per-thread statistics
+    double    time[LB_NUM_KINDS];	// [sec.]
+    double    mark;		// beginning of the current interval
+    long      num_tiles;
+    lb_tile_t worst[LB_STAT_WORST];	// in descending order of time
+    char      pad[CACHE_LINE_SIZE];	// no false sharing with the next thread
+} lb_thread_t;
+
+typedef struct {		// statistics of a PE
+    int          num_threads;
+    lb_thread_t *thread;
+} lb_stat_t;
+
+/* prototypes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LB_STAT_API void   lb_stat_init  (lb_stat_t *);
+LB_STAT_API void   lb_stat_fin   (lb_stat_t *);
+LB_STAT_API void   lb_stat_reset (lb_stat_t *);
+LB_STAT_API void   lb_stat_mark  (lb_stat_t *);
+LB_STAT_API double lb_stat_lap   (lb_stat_t *, lb_kind_t);
+LB_STAT_API void   lb_stat_tile  (lb_stat_t *, tile_t *);
+LB_STAT_API void   lb_stat_sync  (lb_stat_t *);
+LB_STAT_API void   lb_stat_report(lb_stat_t *, const char *);
+
+#ifdef __cplusplus
+}
+#endif
+#undef    LB_STAT_API
+#endif
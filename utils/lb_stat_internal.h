@@ -0,0 +1,12 @@
+/*
+ * lb_stat_internal.h: load balance statistics of hybrid MPI+threads
+ * (c)2026 Seiji Nishimura
+ * $Id: lb_stat_internal.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __LB_STAT_INTERNAL__
+#define __LB_STAT_INTERNAL__
+
+#include "lb_stat.h"
+
+#endif
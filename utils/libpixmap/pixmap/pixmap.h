@@ -35,6 +35,7 @@ extern "C" {
 
 // prototype
 PIXMAP_API void pixmap_create       (pixmap_t *, int  , int  );
+PIXMAP_API void pixmap_allocate     (pixmap_t *, int  , int  );
 PIXMAP_API void pixmap_destroy      (pixmap_t *);
 PIXMAP_API void pixmap_put_pixel    (pixmap_t *, pixel_t  , int, int);
 PIXMAP_API void pixmap_get_pixel    (pixmap_t *, pixel_t *, int, int);
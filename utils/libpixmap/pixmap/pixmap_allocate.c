@@ -0,0 +1,18 @@
+/*
+ * pixmap_allocate.c
+ * (c)2026 Seiji Nishimura
+ * $Id: pixmap_allocate.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include "pixmap_internal.h"
+
+//======================================================================
+void pixmap_allocate(pixmap_t *pixmap, int width, int height)
+{				// allocate a pixmap without pixel initialization.
+    pixmap->data   = (pixel_t *)
+	_pixmap_memory_alloc((size_t) width * height * sizeof(pixel_t), false);
+    pixmap->width  = width ;
+    pixmap->height = height;
+
+    return;
+}
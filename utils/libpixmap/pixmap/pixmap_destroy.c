@@ -4,14 +4,14 @@
  * $Id: pixmap_destroy.c,v 1.1.1.1 2015/11/27 00:00:00 seiji Exp seiji $
  */
 
-#include <stdlib.h>
 #include <string.h>
 #include "pixmap_internal.h"
 
 //======================================================================
 void pixmap_destroy(pixmap_t *pixmap)
 {				// destroy a pixmap.
-    free  (pixmap->data);
+    _pixmap_memory_free(pixmap->data,
+	(size_t) pixmap->width * pixmap->height * sizeof(pixel_t));
     memset(pixmap, 0x00, sizeof(pixmap_t));
 
     return;
@@ -7,6 +7,28 @@
 #ifndef _PIXMAP_INTERNAL_
 #define _PIXMAP_INTERNAL_
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE	200112L
+#endif
+#ifdef  PIXMAP_USE_HUGEPAGE	// for MAP_ANONYMOUS, MAP_HUGETLB and madvise(2)
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// alignment of pixel data [byte]
+#define PIXMAP_ALIGNMENT	4096
+#ifndef PIXMAP_HUGEPAGE_SIZE
+#define PIXMAP_HUGEPAGE_SIZE	(0x01UL<<21)
+#endif
+
 #include "pixmap.h"
 
+// prototypes of library internal procedures
+void *_pixmap_memory_alloc(size_t, bool);
+void  _pixmap_memory_free (void *, size_t);
+
 #endif
@@ -0,0 +1,98 @@
+/*
+ * pixmap_memory.c
+ * (c)2026 Seiji Nishimura
+ * $Id: pixmap_memory.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "pixmap_internal.h"
+
+#ifdef PIXMAP_USE_HUGEPAGE
+#include <sys/mman.h>
+
+#define ROUNDUP(n,a)	((((n)+(a)-1)/(a))*(a))
+
+// prototype of internal procedure
+static void *_pixmap_mmap_hugepage(size_t);
+#endif
+
+//======================================================================
+void *_pixmap_memory_alloc(size_t size, bool clear)
+{				// allocate pixel data memory.
+    void *data;
+#ifdef PIXMAP_USE_HUGEPAGE
+    // anonymous mapping is zero-filled, and no page is touched yet.
+    if ((data = _pixmap_mmap_hugepage(ROUNDUP(size, PIXMAP_HUGEPAGE_SIZE))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+#else
+    int   err = 0;
+
+    if (clear) {		// calloc() clears large blocks lazily.
+	if ((data = calloc(size, sizeof(char))) == NULL)
+	    err = errno;
+    } else
+	err = posix_memalign(&data, PIXMAP_ALIGNMENT, size);
+
+    if (err != 0) {
+	errno = err;
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+#endif
+
+    return data;
+}
+
+//----------------------------------------------------------------------
+void _pixmap_memory_free(void *data, size_t size)
+{				// deallocate pixel data memory.
+#ifdef PIXMAP_USE_HUGEPAGE
+    if (data != NULL)
+	munmap(data, ROUNDUP(size, PIXMAP_HUGEPAGE_SIZE));
+#else
+    free(data);
+#endif
+
+    return;
+}
+
+#ifdef PIXMAP_USE_HUGEPAGE
+//......................................................................
+static void *_pixmap_mmap_hugepage(size_t size)
+{				// map huge page backed memory, size must be aligned.
+    const int prot  = PROT_READ   | PROT_WRITE,
+	      flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    uintptr_t head, tail, p;
+    void *data;
+
+#if defined(PIXMAP_USE_HUGETLB) && defined(MAP_HUGETLB)
+    // explicit huge pages from the pool (vm.nr_hugepages).
+    if ((data = mmap(NULL, size, prot, flags | MAP_HUGETLB, -1, 0)) != MAP_FAILED)
+	return data;
+#endif
+
+    // fallback: transparent huge pages on a huge page aligned region.
+    if ((data = mmap(NULL, size + PIXMAP_HUGEPAGE_SIZE, prot, flags, -1, 0)) == MAP_FAILED)
+	return NULL;
+
+    p    = (uintptr_t) data;
+    head = ROUNDUP(p, PIXMAP_HUGEPAGE_SIZE);
+    tail = p + size + PIXMAP_HUGEPAGE_SIZE;
+
+    if (head > p)		// trim unaligned head and tail.
+	munmap((void *) p, head - p);
+    if (tail > head + size)
+	munmap((void *) (head + size), tail - (head + size));
+
+#ifdef MADV_HUGEPAGE
+    madvise((void *) head, size, MADV_HUGEPAGE);
+#endif
+
+    return (void *) head;
+}
+#endif
@@ -0,0 +1,88 @@
+/*
+ * ppm_io.c: parallel PPM image output
+ * (c)2026 Seiji Nishimura
+ * $Id: ppm_io.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include "ppm_io_internal.h"
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+
+// LF is '\n' on UNIX/LINUX.
+#define LF	0x0a
+
+#define PPM_HEADER_MAX	64
+
+//======================================================================
+int ppm_io_write_rows(const char *fname, int width, int height,
+			int y_head, int y_tail, const pixel_t *rows)
+#ifdef USE_MPI
+{				// collective: write rows [y_head:y_tail) of a width x height raw
+				// PPM image into a file, each PE writes its own rows at their
+				// offset with MPI-IO; rows[0] is the pixel at (0, y_head).
+				// EXIT_SUCCESS is returned if no I/O error happens on all PEs.
+    char         header[PPM_HEADER_MAX];
+    int          len, myrank, err = 0;
+    MPI_File     fh;
+    MPI_Datatype row;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+    len = snprintf(header, PPM_HEADER_MAX, "P6%c%d %d%c255%c", LF, width, height, LF, LF);
+
+    if (MPI_File_open(MPI_COMM_WORLD, fname, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+		      MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+	return EXIT_FAILURE;	// collective, so failed on all PEs.
+
+    // a row is a unit, so that a large row block does not overflow int count.
+    MPI_Type_contiguous(width * SIZEOF_PIXEL_T, MPI_BYTE, &row);
+    MPI_Type_commit(&row);
+
+    // truncate an existing file to the image size.
+    err |= (MPI_File_set_size(fh, len + (MPI_Offset) width * height * SIZEOF_PIXEL_T) != MPI_SUCCESS);
+
+    if (myrank == 0)
+	err |= (MPI_File_write_at(fh, 0, header, len, MPI_CHAR, MPI_STATUS_IGNORE) != MPI_SUCCESS);
+
+    err |= (MPI_File_write_at_all(fh, len + (MPI_Offset) y_head * width * SIZEOF_PIXEL_T,
+			(void *) rows, y_tail - y_head, row, MPI_STATUS_IGNORE) != MPI_SUCCESS);
+
+    err |= (MPI_File_close(&fh) != MPI_SUCCESS);
+    MPI_Type_free(&row);
+
+    MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_BOR, MPI_COMM_WORLD);
+
+    return (err) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#else				//......................................
+{				// write rows [y_head:y_tail) of a width x height raw PPM image,
+				// rows of the other part of the image are left as zero.
+    FILE  *fp;
+    size_t wy;
+
+    if ((fp = fopen(fname, "wb")) == NULL)
+	return EXIT_FAILURE;
+
+    wy = (size_t) width * (y_tail - y_head);
+
+    fprintf(fp, "P6%c%d %d%c255%c", LF, width, height, LF, LF);
+
+    if (ferror(fp) ||
+	fseek(fp, (long) y_head * width * SIZEOF_PIXEL_T, SEEK_CUR) != 0 ||
+	fwrite(rows, sizeof(pixel_t), wy, fp) != wy ||
+	(y_tail < height &&	// extend the file to the image size.
+	 (fseek(fp, (long) (height - y_tail) * width * SIZEOF_PIXEL_T - 1, SEEK_CUR) != 0 ||
+	  fputc(0x00, fp) == EOF))) {
+	fclose(fp);
+	return EXIT_FAILURE;
+    }
+
+    fclose(fp);
+
+    return EXIT_SUCCESS;
+}
+#endif
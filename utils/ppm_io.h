@@ -0,0 +1,30 @@
+/*
+ * ppm_io.h: parallel PPM image output
+ * (c)2026 Seiji Nishimura
+ * $Id: ppm_io.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __PPM_IO_H__
+#define __PPM_IO_H__
+
+#include <pixmap.h>
+
+#ifdef  __PPM_IO_INTERNAL__
+#define   PPM_IO_API
+#else
+#define   PPM_IO_API	extern
+#endif
+
+/* prototype */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+PPM_IO_API int ppm_io_write_rows(const char *, int, int, int, int, const pixel_t *);
+
+#ifdef __cplusplus
+}
+#endif
+#undef    PPM_IO_API
+#endif
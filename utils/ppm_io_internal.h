@@ -0,0 +1,12 @@
+/*
+ * ppm_io_internal.h: parallel PPM image output
+ * (c)2026 Seiji Nishimura
+ * $Id: ppm_io_internal.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __PPM_IO_INTERNAL__
+#define __PPM_IO_INTERNAL__
+
+#include "ppm_io.h"
+
+#endif
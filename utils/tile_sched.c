@@ -0,0 +1,275 @@
+/*
+ * tile_sched.c: tile-based work-stealing scheduler
+ * (c)2026 Seiji Nishimura
+ * $Id: tile_sched.c,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#include "tile_sched_internal.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(x,y)	(((x)<(y))?(x):(y))
+
+// packed representation of deque range [head:tail)
+#define PACK(h,t)	(((unsigned long long) (t) << 32) | (unsigned int) (h))
+#define HEAD(r)		((int) ((r) & 0xffffffffULL))
+#define TAIL(r)		((int) ((r) >> 32))
+
+// prototypes of internal procedures
+static void tile_sched_setup_     (tile_sched_t *, int, int, int, int, int, int);
+static void tile_sched_tile_      (tile_sched_t *, int, tile_t *);
+static int  tile_sched_thread_num_(void);
+static int  tile_sched_compact_   (unsigned int);
+static bool tile_sched_pop_       (tile_deque_t *, int *);
+static bool tile_sched_steal_     (tile_sched_t *, int, int *);
+static void tile_sched_clear_     (tile_sched_t *, char *, size_t, int);
+
+//======================================================================
+void tile_sched_init(tile_sched_t *sched, int width, int height, int nprocs, int myrank)
+{				// initialize scheduler, tiles are dealt to PEs in round-robin.
+    tile_sched_setup_(sched, width, height, 0, height, nprocs, myrank);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_sched_init_rows(tile_sched_t *sched, int width, int height, int y_head, int y_tail)
+{				// initialize scheduler for a row block [y_head:y_tail).
+    tile_sched_setup_(sched, width, height, y_head, y_tail, 1, 0);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_sched_fin(tile_sched_t *sched)
+{				// finalize scheduler.
+    free(sched->order);
+    free(sched->deque);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_sched_reset(tile_sched_t *sched)
+{				// deal contiguous ranges of tiles to threads.
+    int nt = sched->num_tiles ,
+	nd = sched->num_deques;
+
+    for (int i = 0; i < nd; i++)
+	sched->deque[i].range = PACK((long) nt *  i      / nd,
+				     (long) nt * (i + 1) / nd);
+
+    if (sched->reset != NULL)
+	sched->reset(sched->arg);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+void tile_sched_first_touch(tile_sched_t *sched, void *data, size_t size)
+{				// zero-clear a row-major array of size-byte elements.
+				// each tile is first touched by the thread which owns it
+				// after tile_sched_reset(), so that pages are placed on
+				// the NUMA node of the owner (if threads are bound).
+    int   nx = sched->num_tiles_x,
+	  ny = (sched->y_tail - sched->y_head + TILE_HEIGHT - 1) / TILE_HEIGHT,
+	  nt = sched->num_tiles ,
+	  nd = sched->num_deques;
+    char *mine;
+
+    if ((mine = (char *) calloc((size_t) nx * ny, sizeof(char))) == NULL) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+
+    for (int k = 0; k < nt; k++)
+	mine[sched->order[k]] = 1;
+
+#pragma omp parallel
+    {
+	int tid = tile_sched_thread_num_();
+	if (tid < nd)
+	    for (int k = (long) nt * tid / nd; k < (long) nt * (tid + 1) / nd; k++)
+		tile_sched_clear_(sched, (char *) data, size, sched->order[k]);
+	// tiles of other PEs are not rendered here, but must be cleared.
+#pragma omp for schedule(static)
+	for (int id = 0; id < nx * ny; id++)
+	    if (!mine[id])
+		tile_sched_clear_(sched, (char *) data, size, id);
+    }
+
+    free(mine);
+
+    return;
+}
+
+//----------------------------------------------------------------------
+bool tile_sched_next(tile_sched_t *sched, tile_t *tile)
+{				// get next tile, return false if all tiles are done.
+    int tid = tile_sched_thread_num_(), k;
+
+    if (sched->fetch != NULL) {	// tiles are dealt by the external source.
+	if ((k = sched->fetch(sched->arg)) >= sched->num_tiles)
+	    return false;
+    } else if (tid >= sched->num_deques || !tile_sched_pop_(&sched->deque[tid], &k))
+	if (!tile_sched_steal_(sched, tid, &k))
+	    return false;
+
+    tile_sched_tile_(sched, sched->order[k], tile);
+
+    return true;
+}
+
+//----------------------------------------------------------------------
+void tile_sched_set_source(tile_sched_t *sched, tile_fetch_t fetch, tile_reset_t reset, void *arg)
+{				// deal tiles by an external source (e.g. shared among PEs),
+				// fetch() must be thread-safe.
+    sched->fetch = fetch;
+    sched->reset = reset;
+    sched->arg   = arg  ;
+
+    return;
+}
+
+//......................................................................
+static void tile_sched_setup_(tile_sched_t *sched, int width, int height,
+				int y_head, int y_tail, int nprocs, int myrank)
+{				// tiles cover rows [y_head:y_tail).
+    int num_tiles_x = (width  + TILE_WIDTH  - 1) / TILE_WIDTH ,
+	num_tiles_y = (y_tail - y_head + TILE_HEIGHT - 1) / TILE_HEIGHT,
+	num_tiles   = num_tiles_x * num_tiles_y;
+    void *deque;
+    int   n = 0;
+
+    sched->width       = width ;
+    sched->height      = height;
+    sched->y_head      = y_head;
+    sched->y_tail      = y_tail;
+    sched->num_tiles_x = num_tiles_x;
+    sched->num_tiles   = 0;
+    sched->fetch       = NULL;
+    sched->reset       = NULL;
+    sched->arg         = NULL;
+#ifdef _OPENMP
+    sched->num_deques  = omp_get_max_threads();
+#else
+    sched->num_deques  = 1;
+#endif
+
+    if ((sched->order = (int *) malloc((num_tiles + 1) * sizeof(int))) == NULL ||
+	posix_memalign(&deque, CACHE_LINE_SIZE,
+			sched->num_deques * sizeof(tile_deque_t)) != 0) {
+	perror(__func__);
+	exit(EXIT_FAILURE);
+    }
+    sched->deque = (tile_deque_t *) deque;
+
+    // Morton order (Z-order curve) to keep tiles of a thread close together.
+    for (unsigned int code = 0; n < num_tiles; code++) {
+	int tx = tile_sched_compact_(code       ),
+	    ty = tile_sched_compact_(code >> 0x01);
+	if (tx < num_tiles_x && ty < num_tiles_y)
+	    if (n++ % nprocs == myrank)
+		sched->order[sched->num_tiles++] = tx + ty * num_tiles_x;
+    }
+
+    tile_sched_reset(sched);
+
+    return;
+}
+
+//......................................................................
+static void tile_sched_tile_(tile_sched_t *sched, int id, tile_t *tile)
+{				// geometry of a tile.
+    tile->x      = (id % sched->num_tiles_x) * TILE_WIDTH  ;
+    tile->y      = (id / sched->num_tiles_x) * TILE_HEIGHT + sched->y_head;
+    tile->width  = MIN(TILE_WIDTH , sched->width  - tile->x);
+    tile->height = MIN(TILE_HEIGHT, sched->y_tail - tile->y);
+
+    return;
+}
+
+//......................................................................
+static int tile_sched_thread_num_(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+//......................................................................
+static int tile_sched_compact_(unsigned int code)
+{				// gather even bits of Morton code.
+    code &= 0x55555555;
+    code  = (code | (code >> 1)) & 0x33333333;
+    code  = (code | (code >> 2)) & 0x0f0f0f0f;
+    code  = (code | (code >> 4)) & 0x00ff00ff;
+    code  = (code | (code >> 8)) & 0x0000ffff;
+
+    return (int) code;
+}
+
+//......................................................................
+static bool tile_sched_pop_(tile_deque_t *deque, int *k)
+{				// owner takes a tile from the head.
+    unsigned long long range;
+
+    do {
+	range = deque->range;
+	if (HEAD(range) >= TAIL(range))
+	    return false;
+    } while (!__sync_bool_compare_and_swap(&deque->range, range,
+			PACK(HEAD(range) + 1, TAIL(range))));
+
+    *k = HEAD(range);
+
+    return true;
+}
+
+//......................................................................
+static bool tile_sched_steal_(tile_sched_t *sched, int tid, int *k)
+{				// thief takes the latter half of a victim's tiles.
+				// (only one tile if the thief has no deque.)
+    int nd = sched->num_deques;
+
+    for (int i = 1; i <= nd; i++) {
+	tile_deque_t *victim = &sched->deque[(tid + i) % nd];
+	unsigned long long range;
+	int head, tail, mid;
+	do {
+	    range = victim->range;
+	    head  = HEAD(range);
+	    tail  = TAIL(range);
+	    mid   = (tid < nd) ? head + (tail - head) / 2 : tail - 1;
+	} while (head < tail && !__sync_bool_compare_and_swap(&victim->range, range,
+				PACK(head, mid)));
+	if (head >= tail)	// victim has no tile.
+	    continue;
+	*k = mid++;
+	if (mid < tail)		// keep the rest in my own (empty) deque.
+	    sched->deque[tid].range = PACK(mid, tail);
+	return true;
+    }
+
+    return false;
+}
+
+//......................................................................
+static void tile_sched_clear_(tile_sched_t *sched, char *data, size_t size, int id)
+{				// zero-clear a tile.
+    tile_t tile;
+
+    tile_sched_tile_(sched, id, &tile);
+
+    for (int y = tile.y; y < tile.y + tile.height; y++)
+	memset(data + ((size_t) y * sched->width + tile.x) * size, 0x00, tile.width * size);
+
+    return;
+}
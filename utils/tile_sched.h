@@ -0,0 +1,73 @@
+/*
+ * tile_sched.h: tile-based work-stealing scheduler
+ * (c)2026 Seiji Nishimura
+ * $Id: tile_sched.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __TILE_SCHED_H__
+#define __TILE_SCHED_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef  __TILE_SCHED_INTERNAL__
+#define   TILE_SCHED_API
+#else
+#define   TILE_SCHED_API	extern
+#endif
+
+// tile size [pixel]: a row of tile covers multiple cache lines.
+#ifndef TILE_WIDTH
+#define TILE_WIDTH	64
+#endif
+#ifndef TILE_HEIGHT
+#define TILE_HEIGHT	8
+#endif
+
+#define CACHE_LINE_SIZE	64
+
+typedef struct {		// tile
+    int x, y, width, height;
+} tile_t;
+
+typedef struct {		// per-thread deque of tiles, [head:tail) in packed form
+    volatile unsigned long long range;
+    char pad[CACHE_LINE_SIZE - sizeof(unsigned long long)];
+} tile_deque_t;
+
+// external tile source, e.g. a counter shared among PEs.
+typedef int  (*tile_fetch_t)(void *);	// return next tile index (>= # of tiles if none)
+typedef void (*tile_reset_t)(void *);	// rewind the source, called by tile_sched_reset()
+
+typedef struct {		// scheduler
+    int width, height;		// canvas size
+    int y_head, y_tail;		// rows [y_head:y_tail) covered by tiles
+    int num_tiles_x;		// # of tiles in x-direction
+    int num_tiles;		// # of tiles assigned to this PE
+    int num_deques;		// # of threads
+    int          *order;	// tile IDs in Morton order
+    tile_deque_t *deque;
+    tile_fetch_t  fetch;	// tiles are taken from fetch() instead of deques, if set.
+    tile_reset_t  reset;
+    void         *arg;
+} tile_sched_t;
+
+/* prototypes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TILE_SCHED_API void tile_sched_init       (tile_sched_t *, int, int, int, int);
+TILE_SCHED_API void tile_sched_init_rows  (tile_sched_t *, int, int, int, int);
+TILE_SCHED_API void tile_sched_fin        (tile_sched_t *);
+TILE_SCHED_API void tile_sched_reset      (tile_sched_t *);
+TILE_SCHED_API void tile_sched_first_touch(tile_sched_t *, void *, size_t);
+TILE_SCHED_API bool tile_sched_next       (tile_sched_t *, tile_t *);
+TILE_SCHED_API void tile_sched_set_source (tile_sched_t *, tile_fetch_t, tile_reset_t, void *);
+
+#ifdef __cplusplus
+}
+#endif
+#undef    TILE_SCHED_API
+#endif
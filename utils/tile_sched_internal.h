@@ -0,0 +1,16 @@
+/*
+ * tile_sched_internal.h: tile-based work-stealing scheduler
+ * (c)2026 Seiji Nishimura
+ * $Id: tile_sched_internal.h,v 1.1.1.1 2026/10/19 00:00:00 seiji Exp seiji $
+ */
+
+#ifndef __TILE_SCHED_INTERNAL__
+#define __TILE_SCHED_INTERNAL__
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE	200112L
+#endif
+
+#include "tile_sched.h"
+
+#endif